@@ -0,0 +1,578 @@
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+//Scan kernels over numeric columns
+//  - sum, min and max reduce a column, min and max need n > 0
+//  - compare sets bit i of a selection bitmap when data[i] op key holds,
+//    the bitmap has one 64-bit word per 64 values (bits past n are zero)
+//  - count and gather read a bitmap, gather copies the selected values of
+//    any column to out
+//
+//Columns of int64 or double use an AVX-512 (8 lanes) or AVX2 (4 lanes)
+//version selected at runtime when the CPU supports it, other element
+//types and other CPUs use scalar loops. int64 sums wrap around, vector
+//sums of double add in a different order than the scalar loop, and min
+//and max of a column holding NaN are unspecified.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define COLUMN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace column_kernels
+{
+
+enum class cmp_op
+{
+    less,
+    less_equal,
+    greater,
+    greater_equal,
+    equal,
+    not_equal,
+};
+
+template<cmp_op op, typename T>
+    bool matches(T value, T key)
+    {
+        if constexpr(op == cmp_op::less)
+            return value < key;
+        else if constexpr(op == cmp_op::less_equal)
+            return value <= key;
+        else if constexpr(op == cmp_op::greater)
+            return value > key;
+        else if constexpr(op == cmp_op::greater_equal)
+            return value >= key;
+        else if constexpr(op == cmp_op::equal)
+            return value == key;
+        else
+            return value != key;
+    }
+
+//calls f(std::integral_constant<cmp_op, op>{}), kernels get op as a
+//template argument so the inner loops do not branch on it
+template<typename F>
+    void with_op(cmp_op op, F f)
+    {
+        switch(op)
+        {
+        case cmp_op::less: f(std::integral_constant<cmp_op, cmp_op::less>{}); break;
+        case cmp_op::less_equal: f(std::integral_constant<cmp_op, cmp_op::less_equal>{}); break;
+        case cmp_op::greater: f(std::integral_constant<cmp_op, cmp_op::greater>{}); break;
+        case cmp_op::greater_equal: f(std::integral_constant<cmp_op, cmp_op::greater_equal>{}); break;
+        case cmp_op::equal: f(std::integral_constant<cmp_op, cmp_op::equal>{}); break;
+        default: f(std::integral_constant<cmp_op, cmp_op::not_equal>{});
+        }
+    }
+
+template<typename T>
+    T sum_scalar(T const* data, std::size_t n)
+    {
+        //signed integers are added as unsigned so they wrap around
+        using Acc = typename std::conditional_t<std::is_integral_v<T> && std::is_signed_v<T>
+                                                && sizeof(T) >= sizeof(int),
+                                                std::make_unsigned<T>,
+                                                std::enable_if<true, T>>::type;
+        Acc result{};
+        for(std::size_t i = 0; i < n; ++i)
+            result += static_cast<Acc>(data[i]);
+        return static_cast<T>(result);
+    }
+
+template<typename T>
+    T min_scalar(T const* data, std::size_t n)
+    {
+        T result = data[0];
+        for(std::size_t i = 1; i < n; ++i)
+            if(data[i] < result)
+                result = data[i];
+        return result;
+    }
+
+template<typename T>
+    T max_scalar(T const* data, std::size_t n)
+    {
+        T result = data[0];
+        for(std::size_t i = 1; i < n; ++i)
+            if(result < data[i])
+                result = data[i];
+        return result;
+    }
+
+template<cmp_op op, typename T>
+    void compare_scalar(T const* data, std::size_t n, T key, std::uint64_t* bits)
+    {
+        for(std::size_t first = 0; first < n; first += 64){
+            std::size_t last = n - first < 64 ? n : first + 64;
+            std::uint64_t word = 0;
+            for(std::size_t i = first; i < last; ++i)
+                word |= std::uint64_t{matches<op>(data[i], key)} << (i - first);
+            bits[first / 64] = word;
+        }
+    }
+
+#ifdef COLUMN_KERNELS_X86
+
+inline bool has_avx2()
+{
+    static bool const result = __builtin_cpu_supports("avx2");
+    return result;
+}
+
+inline bool has_avx512()
+{
+    static bool const result = __builtin_cpu_supports("avx512f");
+    return result;
+}
+
+//AVX2, 4 lanes of int64 or double
+__attribute__((target("avx2")))
+inline __m256i load4(std::int64_t const* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+}
+
+__attribute__((target("avx2")))
+inline __m256d load4(double const* p)
+{
+    return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2")))
+inline __m256i broadcast4(std::int64_t key)
+{
+    return _mm256_set1_epi64x(key);
+}
+
+__attribute__((target("avx2")))
+inline __m256d broadcast4(double key)
+{
+    return _mm256_set1_pd(key);
+}
+
+__attribute__((target("avx2")))
+inline __m256i add4(__m256i a, __m256i b)
+{
+    return _mm256_add_epi64(a, b);
+}
+
+__attribute__((target("avx2")))
+inline __m256d add4(__m256d a, __m256d b)
+{
+    return _mm256_add_pd(a, b);
+}
+
+__attribute__((target("avx2")))
+inline __m256i min4(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+__attribute__((target("avx2")))
+inline __m256d min4(__m256d a, __m256d b)
+{
+    return _mm256_min_pd(a, b);
+}
+
+__attribute__((target("avx2")))
+inline __m256i max4(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+}
+
+__attribute__((target("avx2")))
+inline __m256d max4(__m256d a, __m256d b)
+{
+    return _mm256_max_pd(a, b);
+}
+
+__attribute__((target("avx2")))
+inline void store4(std::int64_t* p, __m256i v)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+__attribute__((target("avx2")))
+inline void store4(double* p, __m256d v)
+{
+    _mm256_storeu_pd(p, v);
+}
+
+__attribute__((target("avx2")))
+inline int bits4(__m256i cmp)
+{
+    return _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+}
+
+//4 bit mask of the lanes where value op key holds
+template<cmp_op op>
+    __attribute__((target("avx2")))
+    int mask4(__m256i value, __m256i key)
+    {
+        if constexpr(op == cmp_op::less)
+            return bits4(_mm256_cmpgt_epi64(key, value));
+        else if constexpr(op == cmp_op::less_equal)
+            return bits4(_mm256_cmpgt_epi64(value, key)) ^ 0xF;
+        else if constexpr(op == cmp_op::greater)
+            return bits4(_mm256_cmpgt_epi64(value, key));
+        else if constexpr(op == cmp_op::greater_equal)
+            return bits4(_mm256_cmpgt_epi64(key, value)) ^ 0xF;
+        else if constexpr(op == cmp_op::equal)
+            return bits4(_mm256_cmpeq_epi64(value, key));
+        else
+            return bits4(_mm256_cmpeq_epi64(value, key)) ^ 0xF;
+    }
+
+template<cmp_op op>
+    __attribute__((target("avx2")))
+    int mask4(__m256d value, __m256d key)
+    {
+        //ordered predicates are false for NaN, != is true, like operators
+        if constexpr(op == cmp_op::less)
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_LT_OQ));
+        else if constexpr(op == cmp_op::less_equal)
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_LE_OQ));
+        else if constexpr(op == cmp_op::greater)
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_GT_OQ));
+        else if constexpr(op == cmp_op::greater_equal)
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_GE_OQ));
+        else if constexpr(op == cmp_op::equal)
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_EQ_OQ));
+        else
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, key, _CMP_NEQ_UQ));
+    }
+
+template<typename T>
+    __attribute__((target("avx2")))
+    T sum_avx2(T const* data, std::size_t n)
+    {
+        std::size_t i = 0;
+        T lanes[4] = {};
+
+        if(n >= 4){
+            //two accumulators hide the latency of the adds
+            auto a = load4(data), b = load4(lanes);
+            for(i = 4; i + 8 <= n; i += 8){
+                a = add4(a, load4(data + i));
+                b = add4(b, load4(data + i + 4));
+            }
+            store4(lanes, add4(a, b));
+        }
+
+        T partial[2] = {sum_scalar(lanes, 4), sum_scalar(data + i, n - i)};
+        return sum_scalar(partial, 2);
+    }
+
+template<typename T, bool maximum>
+    __attribute__((target("avx2")))
+    T extreme_avx2(T const* data, std::size_t n)
+    {
+        if(n < 4)
+            return maximum ? max_scalar(data, n) : min_scalar(data, n);
+
+        auto best = load4(data);
+        std::size_t i = 4;
+        for(; i + 4 <= n; i += 4)
+            best = maximum ? max4(best, load4(data + i)) : min4(best, load4(data + i));
+
+        //the last 4 values overlap the loop, which is harmless here
+        best = maximum ? max4(best, load4(data + n - 4)) : min4(best, load4(data + n - 4));
+
+        T lanes[4];
+        store4(lanes, best);
+        return maximum ? max_scalar(lanes, 4) : min_scalar(lanes, 4);
+    }
+
+template<cmp_op op, typename T>
+    __attribute__((target("avx2")))
+    void compare_avx2(T const* data, std::size_t n, T key, std::uint64_t* bits)
+    {
+        auto needle = broadcast4(key);
+        std::size_t i = 0;
+
+        //16 vectors fill one bitmap word
+        for(; i + 64 <= n; i += 64){
+            std::uint64_t word = 0;
+            for(int j = 0; j < 16; ++j)
+                word |= std::uint64_t(mask4<op>(load4(data + i + 4 * j), needle)) << (4 * j);
+            bits[i / 64] = word;
+        }
+
+        compare_scalar<op>(data + i, n - i, key, bits + i / 64);
+    }
+
+//AVX-512, 8 lanes of int64 or double
+__attribute__((target("avx512f")))
+inline __m512i load8(std::int64_t const* p)
+{
+    return _mm512_loadu_si512(p);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d load8(double const* p)
+{
+    return _mm512_loadu_pd(p);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i broadcast8(std::int64_t key)
+{
+    return _mm512_set1_epi64(key);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d broadcast8(double key)
+{
+    return _mm512_set1_pd(key);
+}
+
+template<cmp_op op>
+    __attribute__((target("avx512f")))
+    unsigned mask8(__m512i value, __m512i key)
+    {
+        if constexpr(op == cmp_op::less)
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_LT);
+        else if constexpr(op == cmp_op::less_equal)
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_LE);
+        else if constexpr(op == cmp_op::greater)
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_NLE);
+        else if constexpr(op == cmp_op::greater_equal)
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_NLT);
+        else if constexpr(op == cmp_op::equal)
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_EQ);
+        else
+            return _mm512_cmp_epi64_mask(value, key, _MM_CMPINT_NE);
+    }
+
+template<cmp_op op>
+    __attribute__((target("avx512f")))
+    unsigned mask8(__m512d value, __m512d key)
+    {
+        if constexpr(op == cmp_op::less)
+            return _mm512_cmp_pd_mask(value, key, _CMP_LT_OQ);
+        else if constexpr(op == cmp_op::less_equal)
+            return _mm512_cmp_pd_mask(value, key, _CMP_LE_OQ);
+        else if constexpr(op == cmp_op::greater)
+            return _mm512_cmp_pd_mask(value, key, _CMP_GT_OQ);
+        else if constexpr(op == cmp_op::greater_equal)
+            return _mm512_cmp_pd_mask(value, key, _CMP_GE_OQ);
+        else if constexpr(op == cmp_op::equal)
+            return _mm512_cmp_pd_mask(value, key, _CMP_EQ_OQ);
+        else
+            return _mm512_cmp_pd_mask(value, key, _CMP_NEQ_UQ);
+    }
+
+__attribute__((target("avx512f")))
+inline __m512i add8(__m512i a, __m512i b)
+{
+    return _mm512_add_epi64(a, b);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d add8(__m512d a, __m512d b)
+{
+    return _mm512_add_pd(a, b);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i min8(__m512i a, __m512i b)
+{
+    //the masked forms keep GCC 12 from warning about an undefined source
+    return _mm512_mask_min_epi64(a, 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d min8(__m512d a, __m512d b)
+{
+    return _mm512_mask_min_pd(a, 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+inline __m512i max8(__m512i a, __m512i b)
+{
+    return _mm512_mask_max_epi64(a, 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d max8(__m512d a, __m512d b)
+{
+    return _mm512_mask_max_pd(a, 0xFF, a, b);
+}
+
+__attribute__((target("avx512f")))
+inline void store8(std::int64_t* p, __m512i v)
+{
+    _mm512_storeu_si512(p, v);
+}
+
+__attribute__((target("avx512f")))
+inline void store8(double* p, __m512d v)
+{
+    _mm512_storeu_pd(p, v);
+}
+
+template<typename T>
+    __attribute__((target("avx512f")))
+    T sum_avx512(T const* data, std::size_t n)
+    {
+        auto acc = broadcast8(T{});
+        std::size_t i = 0;
+        for(; i + 8 <= n; i += 8)
+            acc = add8(acc, load8(data + i));
+
+        T partial[9];
+        store8(partial, acc);
+        partial[8] = sum_scalar(data + i, n - i);
+        return sum_scalar(partial, 9);
+    }
+
+template<typename T, bool maximum>
+    __attribute__((target("avx512f")))
+    T extreme_avx512(T const* data, std::size_t n)
+    {
+        if(n < 8)
+            return maximum ? max_scalar(data, n) : min_scalar(data, n);
+
+        auto best = load8(data);
+        for(std::size_t i = 8; i + 8 <= n; i += 8)
+            best = maximum ? max8(best, load8(data + i)) : min8(best, load8(data + i));
+        best = maximum ? max8(best, load8(data + n - 8)) : min8(best, load8(data + n - 8));
+
+        T lanes[8];
+        store8(lanes, best);
+        return maximum ? max_scalar(lanes, 8) : min_scalar(lanes, 8);
+    }
+
+template<cmp_op op, typename T>
+    __attribute__((target("avx512f")))
+    void compare_avx512(T const* data, std::size_t n, T key, std::uint64_t* bits)
+    {
+        auto needle = broadcast8(key);
+        std::size_t i = 0;
+
+        //8 vectors fill one bitmap word
+        for(; i + 64 <= n; i += 64){
+            std::uint64_t word = 0;
+            for(int j = 0; j < 8; ++j)
+                word |= std::uint64_t(mask8<op>(load8(data + i + 8 * j), needle)) << (8 * j);
+            bits[i / 64] = word;
+        }
+
+        compare_scalar<op>(data + i, n - i, key, bits + i / 64);
+    }
+
+#endif //COLUMN_KERNELS_X86
+
+//Generic kernels, overloads below take int64 and double columns
+template<typename T>
+    T sum(T const* data, std::size_t n)
+    {
+        return sum_scalar(data, n);
+    }
+
+template<typename T>
+    T min(T const* data, std::size_t n)
+    {
+        return min_scalar(data, n);
+    }
+
+template<typename T>
+    T max(T const* data, std::size_t n)
+    {
+        return max_scalar(data, n);
+    }
+
+template<typename T>
+    void compare(T const* data, std::size_t n, cmp_op op, T key, std::uint64_t* bits)
+    {
+        with_op(op, [&](auto c) {compare_scalar<decltype(c)::value>(data, n, key, bits);});
+    }
+
+//dispatch of the vector kernels, T is std::int64_t or double
+template<typename T>
+    T sum_dispatch(T const* data, std::size_t n)
+    {
+#ifdef COLUMN_KERNELS_X86
+        if(has_avx512())
+            return sum_avx512(data, n);
+        if(has_avx2())
+            return sum_avx2(data, n);
+#endif
+        return sum_scalar(data, n);
+    }
+
+template<typename T, bool maximum>
+    T extreme_dispatch(T const* data, std::size_t n)
+    {
+#ifdef COLUMN_KERNELS_X86
+        if(has_avx512())
+            return extreme_avx512<T, maximum>(data, n);
+        if(has_avx2())
+            return extreme_avx2<T, maximum>(data, n);
+#endif
+        return maximum ? max_scalar(data, n) : min_scalar(data, n);
+    }
+
+template<typename T>
+    void compare_dispatch(T const* data, std::size_t n, cmp_op op, T key, std::uint64_t* bits)
+    {
+        with_op(op, [&](auto c)
+                {
+                    constexpr cmp_op o = decltype(c)::value;
+#ifdef COLUMN_KERNELS_X86
+                    if(has_avx512())
+                        return compare_avx512<o>(data, n, key, bits);
+                    if(has_avx2())
+                        return compare_avx2<o>(data, n, key, bits);
+#endif
+                    compare_scalar<o>(data, n, key, bits);
+                });
+    }
+
+inline std::int64_t sum(std::int64_t const* data, std::size_t n) {return sum_dispatch(data, n);}
+inline double sum(double const* data, std::size_t n) {return sum_dispatch(data, n);}
+inline std::int64_t min(std::int64_t const* data, std::size_t n) {return extreme_dispatch<std::int64_t, false>(data, n);}
+inline double min(double const* data, std::size_t n) {return extreme_dispatch<double, false>(data, n);}
+inline std::int64_t max(std::int64_t const* data, std::size_t n) {return extreme_dispatch<std::int64_t, true>(data, n);}
+inline double max(double const* data, std::size_t n) {return extreme_dispatch<double, true>(data, n);}
+
+inline void compare(std::int64_t const* data, std::size_t n, cmp_op op, std::int64_t key,
+                    std::uint64_t* bits)
+{
+    compare_dispatch(data, n, op, key, bits);
+}
+
+inline void compare(double const* data, std::size_t n, cmp_op op, double key,
+                    std::uint64_t* bits)
+{
+    compare_dispatch(data, n, op, key, bits);
+}
+
+//number of selected values
+inline std::size_t count(std::uint64_t const* bits, std::size_t n)
+{
+    std::size_t result = 0;
+    for(std::size_t w = 0; w < (n + 63) / 64; ++w)
+        result += __builtin_popcountll(bits[w]);
+    return result;
+}
+
+//copy the selected values of data to out in order, return their number
+template<typename T, typename Out>
+    std::size_t gather(T const* data, std::uint64_t const* bits, std::size_t n, Out out)
+    {
+        std::size_t result = 0;
+        for(std::size_t w = 0; w < (n + 63) / 64; ++w)
+            for(std::uint64_t word = bits[w]; word; word &= word - 1){
+                *out++ = data[w * 64 + __builtin_ctzll(word)];
+                ++result;
+            }
+        return result;
+    }
+
+}; //namespace column_kernels
+
+#endif //COLUMN_KERNELS_H
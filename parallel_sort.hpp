@@ -0,0 +1,109 @@
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "thread_pool.hpp"
+#include "timsort.hpp"
+
+//Stable parallel merge sort of a contiguous array
+//  - the array is cut into one run per thread, runs are sorted with
+//    Timsort on the pool
+//  - runs are then merged pairwise into a buffer of the same size,
+//    each merge is cut into independent segments (split points found by
+//    binary search) so every round keeps all threads busy
+//
+//Arrays shorter than min_size are sorted by the calling thread alone.
+//less must be a strict weak ordering and must not throw, T is expected
+//to be a trivially copyable value type. May throw bad_alloc, leaving the
+//array permuted but not sorted.
+
+template<typename T, typename Less>
+void parallel_sort(T *data, std::size_t n, Less less, Thread_Pool& pool,
+                   std::size_t min_size)
+{
+    std::size_t parts = pool.concurrency();
+    if(parts < 2 || n < min_size || n < 2 * parts){
+        timsort(data, data + n, less);
+        return;
+    }
+
+    //run i is [bounds[i], bounds[i + 1])
+    std::vector<std::size_t> bounds(parts + 1);
+    for(std::size_t i = 0; i <= parts; ++i)
+        bounds[i] = n / parts * i + (n % parts) * i / parts;
+
+    pool.parallel_for(parts, [&](std::size_t i)
+                      { timsort(data + bounds[i], data + bounds[i + 1], less); });
+
+    struct segment
+    {
+        std::size_t left, left_end, right, right_end, out;
+    };
+
+    std::vector<T> buffer(n);
+    T *src = data, *dst = buffer.data();
+    std::vector<segment> segments;
+
+    while(bounds.size() > 2){
+        std::size_t runs = bounds.size() - 1;
+        std::size_t pairs = runs / 2;
+        std::size_t split = parts / pairs > 1 ? parts / pairs : 1;
+        std::vector<std::size_t> merged_bounds;
+        segments.clear();
+
+        for(std::size_t p = 0; p < pairs; ++p){
+            std::size_t a = bounds[2 * p], b = bounds[2 * p + 1];
+            std::size_t c = bounds[2 * p + 2];
+            std::size_t i = a, j = b;
+
+            //segment s takes left[i, next_i) and the right values below
+            //left[next_i], equal values stay behind the left ones
+            for(std::size_t s = 1; s <= split; ++s){
+                std::size_t next_i = a + (b - a) * s / split;
+                std::size_t next_j = c;
+                if(s < split)
+                    next_j = std::lower_bound(src + j, src + c, src[next_i], less)
+                             - src;
+
+                segments.push_back(segment{i, next_i, j, next_j,
+                                           i + j - b});
+                i = next_i;
+                j = next_j;
+            }
+            merged_bounds.push_back(a);
+        }
+
+        //odd run out is copied as it is
+        if(runs % 2){
+            std::size_t a = bounds[runs - 1], c = bounds[runs];
+            segments.push_back(segment{a, c, c, c, a});
+            merged_bounds.push_back(a);
+        }
+        merged_bounds.push_back(n);
+
+        pool.parallel_for(segments.size(), [&](std::size_t k)
+                          {
+                              segment const& seg = segments[k];
+                              std::merge(src + seg.left, src + seg.left_end,
+                                         src + seg.right, src + seg.right_end,
+                                         dst + seg.out, less);
+                          });
+
+        bounds.swap(merged_bounds);
+        std::swap(src, dst);
+    }
+
+    if(src != data){
+        std::size_t chunk = (n + parts - 1) / parts;
+        pool.parallel_for(parts, [&](std::size_t i)
+                          {
+                              std::size_t first = std::min(n, i * chunk);
+                              std::size_t last = std::min(n, first + chunk);
+                              std::copy(src + first, src + last, data + first);
+                          });
+    }
+}
+
+#endif //PARALLEL_SORT_H
@@ -1,16 +1,115 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <vector>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <exception>
+#include <memory>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "timsort.hpp"
+#include "parallel_sort.hpp"
+#include "simd_search.hpp"
+#include "rrb_vector.hpp"
 
 /* Python List Object reimplemented in C++
- * Support sequence and iterator protocols
+ * Support sequence, iterator and buffer protocols
  *
  * Notes:
  * Container of ListObject is C++ vector 
  * getitem and insert item at last position are fast
  * insert or delete item at arbitrary index are relatively slow
+ * extend reserves storage once from the length of its argument
+ * sort is a stable Timsort with fast paths for float, int and str keys
+ * index, count and membership scan item identity with SIMD first
+ * == and != compare lengths first, then items identity before __eq__
+ * + and * allocate once and copy whole blocks of items
+ * pop(count), del_indices and retain compact the storage in one pass
+ * reverse, rotate and permute reorder items in place in O(n)
+ * pickling sends typed lists as one raw array (to_bytes / from_bytes)
+ * MappedList keeps typed values in a memory-mapped file instead of RAM
+ * sort, apply_scalar, sum, min and max on large typed storage release
+ * the GIL and split the work over a pool of worker threads
+ *
+ * List(dtype='i8') and List(dtype='f8') store raw int64 / float64 values
+ * contiguously, items are boxed on access and the raw array is exported
+ * through the buffer protocol. Storing a value of any other type moves
+ * the list to object storage (dtype 'O') for good.
+ *
+ * List.view(start, stop, step) returns a ListView which reads and writes
+ * the items of the list in place. Each change of the list length bumps
+ * a version counter, and a view fails once its list version moved on.
+ *
+ * Items live in a refcounted list_storage block. List.copy() shares the
+ * block in O(1) and List.snapshot() iterates it without copying, the
+ * first write to a shared block copies it (copy-on-write).
+ *
+ * PersistentList is an immutable variant stored in an RRB-tree: set,
+ * append, + and slicing return new lists in O(log32 n) which share all
+ * untouched nodes with the original. PersistentList.transient() returns
+ * a TransientList builder which updates nodes it owns in place, and
+ * TransientList.persistent() freezes a snapshot in O(1).
+ */
+
+enum list_dtype
+{
+    OBJECT_DTYPE,
+    INT64_DTYPE,
+    FLOAT64_DTYPE,
+};
+
+static PyObject *box_value(std::int64_t value) {return PyLong_FromLongLong(value);}
+static PyObject *box_value(double value) {return PyFloat_FromDouble(value);}
+static void unbox_value(PyObject *obj, std::int64_t& value) {value = PyLong_AsLongLong(obj);}
+static void unbox_value(PyObject *obj, double& value) {value = PyFloat_AS_DOUBLE(obj);}
+
+static bool
+typed_accepts(list_dtype dtype, PyObject *value)
+{
+    /* Whether value is stored as a raw value of a typed dtype:
+     * 'i8' takes exact ints that fit int64, 'f8' takes exact floats
+     */
+    switch(dtype)
+    {
+    case INT64_DTYPE:
+    {
+        if(!PyLong_CheckExact(value))
+            return false;
+
+        int overflow = 0;
+        PyLong_AsLongLongAndOverflow(value, &overflow);
+        return overflow == 0;
+    }
+
+    case FLOAT64_DTYPE:
+        return PyFloat_CheckExact(value);
+
+    default:
+        return false;
+    }
+}
+
+/* Items of a List, shared by copies and snapshots until one writes
+ * The block owns a reference to each item of container.
  */
+struct list_storage
+{
+    list_storage() = default;
+    list_storage(list_storage const& other);
+    list_storage& operator=(list_storage const&) = delete;
+    ~list_storage();
+
+    inline PyObject *item(list_dtype dtype, Py_ssize_t index) const;
+
+    std::vector<PyObject*> container;       /* OBJECT_DTYPE */
+    std::vector<std::int64_t> int_data;     /* INT64_DTYPE */
+    std::vector<double> float_data;         /* FLOAT64_DTYPE */
+};
 
 class ListObject : public PyObject
 {
@@ -18,69 +117,293 @@ public: /* Public interfaces */
     ListObject();
     ~ListObject();
 
-    Py_ssize_t getlength() const {return this->container.size();};
+    bool is_open() const {return true;};
+    Py_ssize_t getlength() const;
+    list_dtype getdtype() const {return this->dtype;};
+    Py_ssize_t getversion() const {return this->version;};
+    inline PyObject *item(Py_ssize_t index) const;
+    void const *typed_data() const;
     std::tuple<int, PyObject*> getter(Py_ssize_t index);
     std::tuple<int, PyObject*> setter(Py_ssize_t index, PyObject *value);
     std::tuple<int, PyObject*> deleter(Py_ssize_t index);
+    std::tuple<int, PyObject*> inserter(Py_ssize_t index, PyObject *value);
+    std::tuple<int, PyObject*> appender(PyObject *value);
+    std::tuple<int, PyObject*> extend_from(ListObject *other);
+    std::tuple<int, PyObject*> repeat(Py_ssize_t count);
+    std::tuple<int, PyObject*> to_object_storage();
+    std::tuple<int, PyObject*> clear();
+    std::tuple<int, PyObject*> compact(std::vector<char> const& remove);
+    std::tuple<int, PyObject*> pop_tail(Py_ssize_t count, ListObject *dest);
+    std::tuple<int, PyObject*> reverse();
+    std::tuple<int, PyObject*> rotate(Py_ssize_t k);
+    std::tuple<int, PyObject*> permute(std::vector<Py_ssize_t> const& order);
 
-    friend PyObject *list_insert(PyObject *self, PyObject *args);
+    friend int list_init(PyObject *self, PyObject *args, PyObject *kwargs);
+    friend int list_extend_iterable(ListObject *self, PyObject *iterable);
+    friend PyObject *list_sort(PyObject *self, PyObject *args, PyObject *kwargs);
+    friend Py_ssize_t list_find(ListObject *self, PyObject *value,
+                                Py_ssize_t start, Py_ssize_t stop);
+    friend bool list_find_identical(ListObject *self, PyObject *value);
+    friend Py_ssize_t list_count_value(ListObject *self, PyObject *value);
+    friend PyObject *list_richcompare(PyObject *self, PyObject *other, int op);
+    friend PyObject *list_concat(PyObject *self, PyObject *other);
+    friend PyObject *list_repeat(PyObject *self, Py_ssize_t count);
+    friend int list_getbuffer(PyObject *self, Py_buffer *view, int flags);
+    friend void list_releasebuffer(PyObject *self, Py_buffer *view);
+    friend PyObject *list_copy(PyObject *self, PyObject *unused);
+    friend PyObject *list_pop(PyObject *self, PyObject *args);
+    friend PyObject *list_apply_scalar(PyObject *self, PyObject *args);
+    friend PyObject *list_sum(PyObject *self, PyObject *unused);
+    friend PyObject *list_extreme(PyObject *self, char const *name,
+                                  bool maximum);
+    friend PyObject *list_to_bytes(PyObject *self, PyObject *unused);
+    friend PyObject *list_from_bytes(PyObject *cls, PyObject *args,
+                                     PyObject *kwargs);
+    friend PyObject *list_snapshot(PyObject *self, PyObject *unused);
+
+private: /* helper methods */
+    bool accepts(PyObject *value) const;
+    bool is_resizable() const;
+    void reserve(Py_ssize_t size);
+    void shrink_storage();
+    std::tuple<int, PyObject*> unshare();
+    std::tuple<int, PyObject*> lend_storage(std::shared_ptr<list_storage>& block);
+    bool return_storage(std::shared_ptr<list_storage>& block, list_dtype dtype);
+    template<typename F>
+        std::tuple<int, PyObject*> reorder(F f);
 
 private: /* Data members */
-    std::vector<PyObject*> container;
+    list_dtype dtype;
+    std::shared_ptr<list_storage> storage;
+    Py_ssize_t exports;                     /* number of live buffer views */
+    Py_ssize_t export_shape;
+    Py_ssize_t version;                     /* bumped on every resize */
+    Py_ssize_t lent;                        /* sort/apply_scalar calls holding the block */
 };
 
+PyObject*
+list_storage::item(list_dtype dtype, Py_ssize_t index) const
+{
+    /* new reference to item at a valid index, nullptr if boxing fails */
+    switch(dtype)
+    {
+    case INT64_DTYPE:
+        return box_value(this->int_data[index]);
+    case FLOAT64_DTYPE:
+        return box_value(this->float_data[index]);
+    default:
+        PyObject *value = this->container[index];
+        Py_INCREF(value);
+        return value;
+    }
+}
+
+
+PyObject*
+ListObject::item(Py_ssize_t index) const
+{
+    return this->storage->item(this->dtype, index);
+}
+
+/* Sequence slots shared with MappedList, see the typed sequence interface */
+template<typename Seq>
+    Py_ssize_t seq_length(PyObject *self);
+template<typename Seq>
+    PyObject *seq_getitem(PyObject *self, Py_ssize_t index);
+template<typename Seq>
+    int seq_setitem(PyObject *self, Py_ssize_t index, PyObject *value);
+template<typename Seq>
+    PyObject *seq_append(PyObject *self, PyObject *value);
+
 /* Sequence protocol */
-Py_ssize_t list_length(PyObject *self);
-PyObject *list_getitem(PyObject *self, Py_ssize_t index);
-int list_setitem(PyObject *self, Py_ssize_t index, PyObject *value);
+int list_contains(PyObject *self, PyObject *value);
+PyObject *list_concat(PyObject *self, PyObject *other);
+PyObject *list_repeat(PyObject *self, Py_ssize_t count);
+PyObject *list_inplace_concat(PyObject *self, PyObject *other);
+PyObject *list_inplace_repeat(PyObject *self, Py_ssize_t count);
 
 static PySequenceMethods list_sequence = {
-    .sq_length = list_length,
-    .sq_item = list_getitem,
-    .sq_ass_item = list_setitem,
+    .sq_length = seq_length<ListObject>,
+    .sq_concat = list_concat,
+    .sq_repeat = list_repeat,
+    .sq_item = seq_getitem<ListObject>,
+    .sq_ass_item = seq_setitem<ListObject>,
+    .sq_contains = list_contains,
+    .sq_inplace_concat = list_inplace_concat,
+    .sq_inplace_repeat = list_inplace_repeat,
+};
+
+/* Buffer protocol, only typed storage is exported */
+int list_getbuffer(PyObject *self, Py_buffer *view, int flags);
+void list_releasebuffer(PyObject *self, Py_buffer *view);
+
+static PyBufferProcs list_buffer = {
+    .bf_getbuffer = list_getbuffer,
+    .bf_releasebuffer = list_releasebuffer,
 };
 
 PyObject *list_new(PyTypeObject *type, PyObject *args, PyObject *kwargs);
+int list_init(PyObject *self, PyObject *args, PyObject *kwargs);
 void list_dealloc(PyObject *self);
 PyObject *list_insert(PyObject *self, PyObject *args);
+PyObject *list_extend(PyObject *self, PyObject *iterable);
+PyObject *list_sort(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *list_index(PyObject *self, PyObject *args);
+PyObject *list_count(PyObject *self, PyObject *value);
+PyObject *list_pop(PyObject *self, PyObject *args);
+PyObject *list_del_indices(PyObject *self, PyObject *indices);
+PyObject *list_retain(PyObject *self, PyObject *predicate);
+PyObject *list_reverse(PyObject *self, PyObject *unused);
+PyObject *list_rotate(PyObject *self, PyObject *args);
+PyObject *list_permute(PyObject *self, PyObject *order);
+PyObject *list_apply_scalar(PyObject *self, PyObject *args);
+PyObject *list_sum(PyObject *self, PyObject *unused);
+PyObject *list_min(PyObject *self, PyObject *unused);
+PyObject *list_max(PyObject *self, PyObject *unused);
+PyObject *list_reversed(PyObject *self, PyObject *unused);
+PyObject *list_view(PyObject *self, PyObject *args);
+PyObject *list_copy(PyObject *self, PyObject *unused);
+PyObject *list_snapshot(PyObject *self, PyObject *unused);
+PyObject *list_reduce(PyObject *self, PyObject *unused);
+PyObject *list_to_bytes(PyObject *self, PyObject *unused);
+PyObject *list_from_bytes(PyObject *cls, PyObject *args, PyObject *kwargs);
 
 static PyMethodDef list_methods[] = {
     {"insert", list_insert, METH_VARARGS, nullptr},
+    {"append", seq_append<ListObject>, METH_O, nullptr},
+    {"extend", list_extend, METH_O, nullptr},
+    {"sort", (PyCFunction)(void(*)(void)) list_sort,
+        METH_VARARGS | METH_KEYWORDS, nullptr},
+    {"index", list_index, METH_VARARGS, nullptr},
+    {"count", list_count, METH_O, nullptr},
+    {"pop", list_pop, METH_VARARGS, nullptr},
+    {"del_indices", list_del_indices, METH_O, nullptr},
+    {"retain", list_retain, METH_O, nullptr},
+    {"reverse", list_reverse, METH_NOARGS, nullptr},
+    {"rotate", list_rotate, METH_VARARGS, nullptr},
+    {"permute", list_permute, METH_O, nullptr},
+    {"apply_scalar", list_apply_scalar, METH_VARARGS, nullptr},
+    {"sum", list_sum, METH_NOARGS, nullptr},
+    {"min", list_min, METH_NOARGS, nullptr},
+    {"max", list_max, METH_NOARGS, nullptr},
+    {"__reversed__", list_reversed, METH_NOARGS, nullptr},
+    {"view", list_view, METH_VARARGS, nullptr},
+    {"copy", list_copy, METH_NOARGS, nullptr},
+    {"snapshot", list_snapshot, METH_NOARGS, nullptr},
+    {"__reduce__", list_reduce, METH_NOARGS, nullptr},
+    {"to_bytes", list_to_bytes, METH_NOARGS, nullptr},
+    {"from_bytes", (PyCFunction)(void(*)(void)) list_from_bytes,
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS, nullptr},
     {nullptr, nullptr, 0, nullptr},
 };
 
-/* Iterator protocol */
+PyObject *list_get_dtype(PyObject *self, void *closure);
+
+static PyGetSetDef list_getset[] = {
+    {"dtype", list_get_dtype, nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+/* Iterator protocol
+ * Iterators read the storage of the list directly, without bounds
+ * checked getter, and drop their reference to the list once exhausted.
+ * Snapshot iterators hold the storage block itself, so they see the
+ * items as they were when created.
+ */
 PyObject *list_iter(PyObject *self);
+PyObject *listiter_iter(PyObject *self);
 PyObject *list_iternext(PyObject *self);
+PyObject *list_reviternext(PyObject *self);
+PyObject *list_snapshotnext(PyObject *self);
 
 struct ListIterObject : public PyObject
 {
-    ListIterObject(ListObject *_list);
+    ListIterObject(ListObject *_list, PyTypeObject *type, Py_ssize_t start);
     ~ListIterObject();
 
     Py_ssize_t currentpos;
     ListObject *list; 
 };
 
+struct ListSnapshotIterObject : public PyObject
+{
+    ListSnapshotIterObject(std::shared_ptr<list_storage> _storage,
+                           list_dtype _dtype, Py_ssize_t _length);
+
+    std::shared_ptr<list_storage> storage;  /* released once exhausted */
+    list_dtype dtype;
+    Py_ssize_t currentpos;
+    Py_ssize_t length;
+};
+
 void listiter_dealloc(PyObject *self);
+void listsnapshot_dealloc(PyObject *self);
+PyObject *listiter_length_hint(PyObject *self, PyObject *unused);
+PyObject *listreviter_length_hint(PyObject *self, PyObject *unused);
+PyObject *listsnapshot_length_hint(PyObject *self, PyObject *unused);
+
+static PyMethodDef listiter_methods[] = {
+    {"__length_hint__", listiter_length_hint, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyMethodDef listreviter_methods[] = {
+    {"__length_hint__", listreviter_length_hint, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyMethodDef listsnapshot_methods[] = {
+    {"__length_hint__", listsnapshot_length_hint, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
 
 static PyTypeObject ListIterType = {
-    PyVarObject_HEAD_INIT(NULL, 0)
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
     .tp_name = "ListIter",
-    .tp_doc = "Iteration type of list object",
+    .tp_basicsize = sizeof(ListIterObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = listiter_dealloc,
     .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Iteration type of list object",
+    .tp_iter = &listiter_iter,
+    .tp_iternext = &list_iternext,
+    .tp_methods = listiter_methods,
     .tp_new = nullptr,
-    .tp_dealloc = listiter_dealloc,
+};
+
+static PyTypeObject ListRevIterType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ListRevIter",
     .tp_basicsize = sizeof(ListIterObject),
     .tp_itemsize = 0,
-    .tp_iter = &list_iter,
-    .tp_iternext = &list_iternext,
+    .tp_dealloc = listiter_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Reverse iteration type of list object",
+    .tp_iter = &listiter_iter,
+    .tp_iternext = &list_reviternext,
+    .tp_methods = listreviter_methods,
+    .tp_new = nullptr,
+};
+
+static PyTypeObject ListSnapshotIterType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ListSnapshotIter",
+    .tp_basicsize = sizeof(ListSnapshotIterObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = listsnapshot_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Iteration type over a snapshot of list object",
+    .tp_iter = &listiter_iter,
+    .tp_iternext = &list_snapshotnext,
+    .tp_methods = listsnapshot_methods,
+    .tp_new = nullptr,
 };
 
 
-ListIterObject::ListIterObject(ListObject *_list)
-        : PyObject{0, &ListIterType},
-          currentpos{0}, list{_list}
+ListIterObject::ListIterObject(ListObject *_list, PyTypeObject *type,
+                               Py_ssize_t start)
+        : PyObject{0, type},
+          currentpos{start}, list{_list}
 {
     Py_INCREF(this->list);
 }
@@ -102,33 +425,155 @@ listiter_dealloc(PyObject *self)
 }
 
 
-static PyTypeObject ListType = {
-    PyVarObject_HEAD_INIT(NULL, 0)
-    .tp_name = "List",
-    .tp_doc = "List object reimplemented in C++",
+ListSnapshotIterObject::ListSnapshotIterObject(
+        std::shared_ptr<list_storage> _storage, list_dtype _dtype,
+        Py_ssize_t _length)
+        : PyObject{0, &ListSnapshotIterType}, storage{std::move(_storage)},
+          dtype{_dtype}, currentpos{0}, length{_length}
+{/* Empty body */}
+
+
+void
+listsnapshot_dealloc(PyObject *self)
+{
+    ListSnapshotIterObject *_self = static_cast<ListSnapshotIterObject*>(self);
+    delete _self;
+}
+
+
+/* Slice view over a List, items are neither copied nor increfed */
+struct ListViewObject : public PyObject
+{
+    ListViewObject(ListObject *_list, Py_ssize_t _start, Py_ssize_t _step,
+                   Py_ssize_t _length);
+    ~ListViewObject();
+
+    bool is_valid() const;
+    Py_ssize_t parent_index(Py_ssize_t index) const
+    {
+        return this->start + index * this->step;
+    };
+
+    ListObject *list;
+    Py_ssize_t start;
+    Py_ssize_t step;
+    Py_ssize_t length;
+    Py_ssize_t version;     /* version of list when the view was taken */
+};
+
+void listview_dealloc(PyObject *self);
+Py_ssize_t listview_length(PyObject *self);
+PyObject *listview_getitem(PyObject *self, Py_ssize_t index);
+int listview_setitem(PyObject *self, Py_ssize_t index, PyObject *value);
+
+static PySequenceMethods listview_sequence = {
+    .sq_length = listview_length,
+    .sq_item = listview_getitem,
+    .sq_ass_item = listview_setitem,
+};
+
+static PyTypeObject ListViewType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "ListView",
+    .tp_basicsize = sizeof(ListViewObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = listview_dealloc,
+    .tp_as_sequence = &listview_sequence,
     .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Zero-copy slice of a List, invalidated when the List is resized",
+    .tp_iter = PySeqIter_New,
+    .tp_new = nullptr,
+};
+
+
+PyObject *list_richcompare(PyObject *self, PyObject *other, int op);
+
+static PyTypeObject ListType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "list.List",
     .tp_basicsize = sizeof(ListObject),
     .tp_itemsize = 0,
-    .tp_new = list_new,
     .tp_dealloc = list_dealloc,
     .tp_as_sequence = &list_sequence,
-    .tp_methods = list_methods,
+    .tp_hash = PyObject_HashNotImplemented,
+    .tp_as_buffer = &list_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "List object reimplemented in C++",
+    .tp_richcompare = list_richcompare,
     .tp_iter = list_iter,
+    .tp_methods = list_methods,
+    .tp_getset = list_getset,
+    .tp_init = list_init,
+    .tp_new = list_new,
+};
+
+
+enum status
+{
+    SUCCESS,
+    ERROR,
 };
 
 
 ListObject::ListObject()
-        : PyObject{0, &ListType}, container{}
+        : PyObject{0, &ListType}, dtype{OBJECT_DTYPE},
+          storage{std::make_shared<list_storage>()},
+          exports{0}, export_shape{0}, version{0}, lent{0}
 {/* Empty body */}
 
 
 ListObject::~ListObject()
+{
+    assert(this->exports == 0 && "ListObject has live buffer views");
+}
+
+
+list_storage::list_storage(list_storage const& other)
+        : container{other.container}, int_data{other.int_data},
+          float_data{other.float_data}
+{
+    for(PyObject *obj : this->container)
+        Py_INCREF(obj);
+}
+
+
+list_storage::~list_storage()
 {
     for(PyObject*& obj : this->container)
         Py_CLEAR(obj);
 }
 
 
+Py_ssize_t
+ListObject::getlength() const
+{
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        return this->storage->int_data.size();
+    case FLOAT64_DTYPE:
+        return this->storage->float_data.size();
+    default:
+        return this->storage->container.size();
+    }
+}
+
+
+void const*
+ListObject::typed_data() const
+{
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        return this->storage->int_data.data();
+    case FLOAT64_DTYPE:
+        return this->storage->float_data.data();
+    default:
+        return nullptr;
+    }
+}
+
+
 PyObject *list_new(PyTypeObject *type, PyObject*, PyObject*)
 {
 
@@ -149,6 +594,61 @@ PyObject *list_new(PyTypeObject *type, PyObject*, PyObject*)
 }
 
 
+static bool
+parse_dtype(char const *name, list_dtype& dtype)
+{
+    /* nullptr means the default object storage */
+    if(!name || std::strcmp(name, "O") == 0)
+        dtype = OBJECT_DTYPE;
+    else if(std::strcmp(name, "i8") == 0)
+        dtype = INT64_DTYPE;
+    else if(std::strcmp(name, "f8") == 0)
+        dtype = FLOAT64_DTYPE;
+    else {
+        PyErr_Format(PyExc_ValueError,
+                     "dtype must be 'O', 'i8' or 'f8', not '%s'", name);
+        return false;
+    }
+
+    return true;
+}
+
+
+int
+list_init(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    PyObject *iterable = nullptr;
+    char const *dtype = nullptr;
+
+    static char const *kwlist[] = {"iterable", "dtype", nullptr};
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|Oz:List",
+                                    const_cast<char**>(kwlist),
+                                    &iterable, &dtype))
+        return -1;
+
+    list_dtype new_dtype = OBJECT_DTYPE;
+    if(!parse_dtype(dtype, new_dtype))
+        return -1;
+
+    /* Like builtin list, __init__ replaces the current content */
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->clear();
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return -1;
+    }
+    _self->dtype = new_dtype;
+
+    if(!iterable)
+        return 0;
+
+    return list_extend_iterable(_self, iterable);
+}
+
+
 void 
 list_dealloc(PyObject *self)
 {
@@ -157,52 +657,92 @@ list_dealloc(PyObject *self)
 }
 
 
-Py_ssize_t
-list_length(PyObject *self)
+/* Typed sequence interface
+ * List and MappedList share the sequence slots below, both types provide
+ *   is_open()              false once the storage is gone (MappedList.close)
+ *   getlength(), getdtype()
+ *   getter, setter, deleter, appender
+ *                          status tuples, raw values follow typed_accepts
+ *   typed_data()           raw int64 / float64 values of typed storage
+ */
+static void
+set_status_error(PyObject *error)
 {
-    ListObject *_self = static_cast<ListObject*>(self);
-    return _self->getlength();
+    /* an exception the callee set already carries its own message */
+    if(PyErr_Occurred())
+        return;
+
+    /* OSError carries errno of the failed system call */
+    if(error == PyExc_OSError)
+        PyErr_SetFromErrno(PyExc_OSError);
+    else
+        PyErr_SetNone(error);
 }
 
 
-enum status
+template<typename Seq>
+static bool
+check_open(Seq *self)
 {
-    SUCCESS,
-    ERROR,
-};
+    if(self->is_open())
+        return true;
+
+    PyErr_Format(PyExc_ValueError, "%s is closed", Py_TYPE(self)->tp_name);
+    return false;
+}
+
+
+template<typename Seq>
+Py_ssize_t
+seq_length(PyObject *self)
+{
+    Seq *_self = static_cast<Seq*>(self);
+
+    if(!check_open(_self))
+        return -1;
+
+    return _self->getlength();
+}
 
 
+template<typename Seq>
 PyObject*
-list_getitem(PyObject *self, Py_ssize_t index)
+seq_getitem(PyObject *self, Py_ssize_t index)
 {
-    ListObject *_self = static_cast<ListObject*>(self);
+    Seq *_self = static_cast<Seq*>(self);
+
+    if(!check_open(_self))
+        return nullptr;
+
     int status = 0;
-    PyObject *value = nullptr;
+    PyObject *result = nullptr;
 
-    std::tie(status, value) = _self->getter(index); 
-    
+    std::tie(status, result) = _self->getter(index);
     if(status == ERROR){
-        PyErr_SetNone(value);
-        return NULL;
+        set_status_error(result);
+        return nullptr;
     }
 
-    return value;
+    return result;
 }
 
 
+template<typename Seq>
 int
-list_setitem(PyObject *self, Py_ssize_t index, PyObject *value)
+seq_setitem(PyObject *self, Py_ssize_t index, PyObject *value)
 {
-    ListObject *_self = static_cast<ListObject*>(self);
+    Seq *_self = static_cast<Seq*>(self);
+
+    if(!check_open(_self))
+        return -1;
 
     int status = 0;
-    PyObject *error= nullptr;
+    PyObject *error = nullptr;
 
     std::tie(status, error) = value ? _self->setter(index, value)
                                     : _self->deleter(index);
-   
     if(status == ERROR){
-        PyErr_SetNone(error); 
+        set_status_error(error);
         return -1;
     }
 
@@ -210,6 +750,28 @@ list_setitem(PyObject *self, Py_ssize_t index, PyObject *value)
 }
 
 
+template<typename Seq>
+PyObject*
+seq_append(PyObject *self, PyObject *value)
+{
+    Seq *_self = static_cast<Seq*>(self);
+
+    if(!check_open(_self))
+        return nullptr;
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->appender(value);
+    if(status == ERROR){
+        set_status_error(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
 PyObject*
 list_insert(PyObject *self, PyObject *args)
 {
@@ -228,128 +790,4403 @@ list_insert(PyObject *self, PyObject *args)
     if(index == -1)
         index = last_index;
 
-    if(index < 0 || index > last_index){
-        PyErr_SetNone(PyExc_IndexError);
-        return nullptr;
-    }
+    int status = 0;
+    PyObject *error = nullptr;
 
-    /* Insert a place holder into container */
-    try
-    {
-        _self->container.push_back(nullptr);
-    }
-    catch (std::bad_alloc)
-    {
-        PyErr_NoMemory();
+    std::tie(status, error) = _self->inserter(index, value);
+    if(status == ERROR){
+        PyErr_SetNone(error);
         return nullptr;
     }
-    
-    /* shift list items to make room for new item */
-    for(Py_ssize_t i = last_index; i > index; --i){
-        _self->container[i] = _self->container[i - 1];
-    }
 
-    Py_INCREF(value);
-    _self->container[index] = value;
     Py_RETURN_NONE;
 }
 
-/* Implemetation of iterator protocol */
-PyObject*
-list_iter(PyObject *self)
+
+static int
+extend_items(ListObject *self, PyObject **items, Py_ssize_t n)
 {
-    if(Py_TYPE(self) == &ListIterType)
-        return self;
+    /* Append items one by one, storage is expected to be reserved */
+    for(Py_ssize_t i = 0; i < n; ++i){
+        int status = 0;
+        PyObject *error = nullptr;
 
-    ListObject *_self = static_cast<ListObject*>(self);
-    ListIterObject *iterobj = new ListIterObject{_self};
-    Py_INCREF(iterobj);
+        std::tie(status, error) = self->appender(items[i]);
+        if(status == ERROR){
+            PyErr_SetNone(error);
+            return -1;
+        }
+    }
 
-    return static_cast<PyObject*>(iterobj);
+    return 0;
 }
 
 
-PyObject*
-list_iternext(PyObject *self)
+int
+list_extend_iterable(ListObject *self, PyObject *iterable)
 {
-    ListIterObject *_self = static_cast<ListIterObject*>(self);
-
-    if(_self->currentpos >= _self->list->getlength())
-        return nullptr;
+    /* Append every item of iterable to self
+     * return 0 on success, -1 with exception set on failure
+     * storage is reserved once, either from the exact length of
+     * a List / list / tuple or from PyObject_LengthHint otherwise
+     */
+    if(!self->is_resizable()){
+        PyErr_SetNone(PyExc_BufferError);
+        return -1;
+    }
 
-    PyObject *value = nullptr;
     int status = 0;
+    PyObject *error = nullptr;
 
-    std::tie(status, value) = _self->list->getter(_self->currentpos);
+    std::tie(status, error) = self->unshare();
     if(status == ERROR){
-        PyErr_SetNone(value);
-        return nullptr;
+        PyErr_SetNone(error);
+        return -1;
     }
+    self->version += 1;
 
-    Py_INCREF(value);
-    _self->currentpos += 1;
-    return value;
-}
+    Py_ssize_t old_size = self->getlength();
 
+    /* Fast path: copy a block from another List (may be self) */
+    if(Py_TYPE(iterable) == &ListType){
+        std::tie(status, error) =
+                self->extend_from(static_cast<ListObject*>(iterable));
+        if(status == ERROR){
+            PyErr_SetNone(error);
+            return -1;
+        }
 
-std::tuple<int, PyObject*>
-ListObject::getter(Py_ssize_t index)
-{
-    if(index < 0 || index >= this->getlength())
-        return std::make_tuple(ERROR, PyExc_IndexError);
+        return 0;
+    }
 
-    return std::make_tuple(SUCCESS, this->container[index]);
-}
+    /* Fast path: builtin list and tuple expose a contiguous item array */
+    if(PyList_CheckExact(iterable) || PyTuple_CheckExact(iterable)){
+        PyObject *seq = PySequence_Fast(iterable, "argument must be iterable");
+        if(!seq)
+            return -1;
 
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+        PyObject **items = PySequence_Fast_ITEMS(seq);
 
-std::tuple<int, PyObject*>
-ListObject::setter(Py_ssize_t index, PyObject *value)
-{
+        try
+        {
+            self->reserve(old_size + n);
+        }
+        catch (std::bad_alloc)
+        {
+            Py_DECREF(seq);
+            PyErr_NoMemory();
+            return -1;
+        }
+
+        int result = 0;
+        if(self->dtype == OBJECT_DTYPE){
+            for(Py_ssize_t i = 0; i < n; ++i)
+                Py_INCREF(items[i]);
+            self->storage->container.insert(self->storage->container.end(), items, items + n);
+        } else {
+            result = extend_items(self, items, n);
+        }
+
+        Py_DECREF(seq);
+        return result;
+    }
+
+    /* Generic path: presize from length hint, then drain the iterator */
+    PyObject *iter = PyObject_GetIter(iterable);
+    if(!iter)
+        return -1;
+
+    Py_ssize_t hint = PyObject_LengthHint(iterable, 0);
+    if(hint < 0){
+        Py_DECREF(iter);
+        return -1;
+    }
+
+    /* the hint is only advice, a bogus one means no presizing */
+    if(hint > PY_SSIZE_T_MAX - old_size)
+        hint = PY_SSIZE_T_MAX - old_size;
+
+    try
+    {
+        self->reserve(old_size + hint);
+    }
+    catch (std::bad_alloc)
+    {
+    }
+
+    PyObject *item = nullptr;
+    while((item = PyIter_Next(iter))){
+        int result = extend_items(self, &item, 1);
+        Py_DECREF(item);
+
+        if(result < 0){
+            Py_DECREF(iter);
+            return -1;
+        }
+    }
+
+    Py_DECREF(iter);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+
+PyObject*
+list_extend(PyObject *self, PyObject *iterable)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(list_extend_iterable(_self, iterable) < 0)
+        return nullptr;
+
+    Py_RETURN_NONE;
+}
+
+
+/* Concatenation and repetition */
+PyObject*
+list_concat(PyObject *self, PyObject *other)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(Py_TYPE(other) != &ListType){
+        PyErr_Format(PyExc_TypeError,
+                     "can only concatenate List (not \"%.200s\") to List",
+                     Py_TYPE(other)->tp_name);
+        return nullptr;
+    }
+
+    ListObject *_other = static_cast<ListObject*>(other);
+    ListObject *result = nullptr;
+
+    try
+    {
+        result = new ListObject{};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+    Py_INCREF(result);
+
+    /* Typed result only when both sides share the storage type */
+    if(_self->dtype == _other->dtype)
+        result->dtype = _self->dtype;
+
+    Py_ssize_t size = _self->getlength() + _other->getlength();
+    int status = SUCCESS;
+    PyObject *error = nullptr;
+
+    try
+    {
+        result->reserve(size);
+    }
+    catch (std::bad_alloc)
+    {
+        std::tie(status, error) = std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    if(status == SUCCESS)
+        std::tie(status, error) = result->extend_from(_self);
+    if(status == SUCCESS)
+        std::tie(status, error) = result->extend_from(_other);
+
+    if(status == ERROR){
+        Py_DECREF(result);
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    return static_cast<PyObject*>(result);
+}
+
+
+PyObject*
+list_repeat(PyObject *self, Py_ssize_t count)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    ListObject *result = nullptr;
+
+    try
+    {
+        result = new ListObject{};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+    Py_INCREF(result);
+    result->dtype = _self->dtype;
+
+    if(count <= 0)
+        return static_cast<PyObject*>(result);
+
+    /* Reserve the final size, so repeat copies without reallocation */
+    Py_ssize_t size = _self->getlength();
+    int status = SUCCESS;
+    PyObject *error = nullptr;
+
+    if(size > PY_SSIZE_T_MAX / count)
+        std::tie(status, error) = std::make_tuple(ERROR, PyExc_MemoryError);
+
+    if(status == SUCCESS){
+        try
+        {
+            result->reserve(size * count);
+        }
+        catch (std::bad_alloc)
+        {
+            std::tie(status, error) = std::make_tuple(ERROR, PyExc_MemoryError);
+        }
+    }
+
+    if(status == SUCCESS)
+        std::tie(status, error) = result->extend_from(_self);
+    if(status == SUCCESS)
+        std::tie(status, error) = result->repeat(count);
+
+    if(status == ERROR){
+        Py_DECREF(result);
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    return static_cast<PyObject*>(result);
+}
+
+
+PyObject*
+list_inplace_concat(PyObject *self, PyObject *other)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(list_extend_iterable(_self, other) < 0)
+        return nullptr;
+
+    Py_INCREF(self);
+    return self;
+}
+
+
+PyObject*
+list_inplace_repeat(PyObject *self, Py_ssize_t count)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->repeat(count);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_INCREF(self);
+    return self;
+}
+
+/* Worker threads for typed storage
+ * Arrays of at least PARALLEL_MIN_SIZE values are processed on the pool
+ * with the GIL released, smaller ones by the calling thread. The pool is
+ * created on first use, a child process after fork gets no workers.
+ */
+static constexpr Py_ssize_t PARALLEL_MIN_SIZE = Py_ssize_t{1} << 16;
+
+static Thread_Pool&
+list_pool()
+{
+    static pid_t const owner = getpid();
+    static unsigned const cores = std::thread::hardware_concurrency();
+    static Thread_Pool pool{cores > 1 ? cores - 1 : 0};
+    static Thread_Pool serial{0};
+
+    return getpid() == owner ? pool : serial;
+}
+
+/* Sorting
+ * Items are decorated with their key, the decorated array is sorted
+ * and values are written back only when every comparison succeeded.
+ * When all keys are exact float, int (fitting in long long) or str,
+ * keys are compared natively instead of through PyObject_RichCompare.
+ */
+struct CompareError: public std::exception
+{
+    virtual const char *what() const noexcept
+    {
+        return "Exception raised by rich comparison";
+    }
+};
+
+enum key_kind
+{
+    GENERIC_KEYS,
+    FLOAT_KEYS,
+    INT_KEYS,
+    STR_KEYS,
+};
+
+template<typename K>
+struct SortEntry
+{
+    K key;
+    PyObject *value;
+};
+
+
+static key_kind
+classify_keys(PyObject **keys, Py_ssize_t n)
+{
+    if(n == 0)
+        return GENERIC_KEYS;
+
+    PyTypeObject *type = Py_TYPE(keys[0]);
+    for(Py_ssize_t i = 1; i < n; ++i)
+        if(Py_TYPE(keys[i]) != type)
+            return GENERIC_KEYS;
+
+    if(type == &PyFloat_Type)
+        return FLOAT_KEYS;
+
+    if(type == &PyUnicode_Type)
+        return STR_KEYS;
+
+    if(type == &PyLong_Type){
+        for(Py_ssize_t i = 0; i < n; ++i){
+            int overflow = 0;
+            PyLong_AsLongLongAndOverflow(keys[i], &overflow);
+            if(overflow)
+                return GENERIC_KEYS;
+        }
+        return INT_KEYS;
+    }
+
+    return GENERIC_KEYS;
+}
+
+
+static bool
+unicode_less(PyObject *a, PyObject *b)
+{
+    /* Both arguments are exact str, compare latin-1 strings with memcmp */
+    if(PyUnicode_KIND(a) == PyUnicode_1BYTE_KIND
+            && PyUnicode_KIND(b) == PyUnicode_1BYTE_KIND){
+        Py_ssize_t len_a = PyUnicode_GET_LENGTH(a);
+        Py_ssize_t len_b = PyUnicode_GET_LENGTH(b);
+        int res = std::memcmp(PyUnicode_DATA(a), PyUnicode_DATA(b),
+                              len_a < len_b ? len_a : len_b);
+        return res != 0 ? res < 0 : len_a < len_b;
+    }
+
+    return PyUnicode_Compare(a, b) < 0;
+}
+
+
+static bool
+object_less(PyObject *a, PyObject *b)
+{
+    int res = PyObject_RichCompareBool(a, b, Py_LT);
+    if(res < 0)
+        throw CompareError{};
+    return res;
+}
+
+
+template<typename K, typename Extract, typename Less>
+static void
+sort_decorated(PyObject **values, PyObject **keys, Py_ssize_t n,
+               Extract extract, Less less, bool reverse)
+{
+    /* Sort values by keys, stable for both directions
+     * may throw bad_alloc or CompareError, values stay intact in that case
+     */
+    using Entry = SortEntry<K>;
+    std::vector<Entry> entries;
+    entries.reserve(n);
+
+    for(Py_ssize_t i = 0; i < n; ++i)
+        entries.push_back(Entry{extract(keys[i]), values[i]});
+
+    if(reverse)
+        timsort(entries.begin(), entries.end(),
+                [&less](Entry const& a, Entry const& b)
+                { return less(b.key, a.key); });
+    else
+        timsort(entries.begin(), entries.end(),
+                [&less](Entry const& a, Entry const& b)
+                { return less(a.key, b.key); });
+
+    for(Py_ssize_t i = 0; i < n; ++i)
+        values[i] = entries[i].value;
+}
+
+
+static void
+sort_items(PyObject **values, PyObject **keys, Py_ssize_t n, bool reverse)
+{
+    auto borrow = [](PyObject *key) { return key; };
+
+    switch(classify_keys(keys, n))
+    {
+    case FLOAT_KEYS:
+        sort_decorated<double>(values, keys, n,
+                               [](PyObject *key)
+                               { return PyFloat_AS_DOUBLE(key); },
+                               [](double a, double b) { return a < b; },
+                               reverse);
+        break;
+
+    case INT_KEYS:
+        sort_decorated<long long>(values, keys, n,
+                                  [](PyObject *key)
+                                  { return PyLong_AsLongLong(key); },
+                                  [](long long a, long long b)
+                                  { return a < b; },
+                                  reverse);
+        break;
+
+    case STR_KEYS:
+        sort_decorated<PyObject*>(values, keys, n, borrow,
+                                  unicode_less, reverse);
+        break;
+
+    default:
+        sort_decorated<PyObject*>(values, keys, n, borrow,
+                                  object_less, reverse);
+    }
+}
+
+
+static bool
+sort_boxed(std::vector<PyObject*>& items, PyObject *keyfunc, bool reverse)
+{
+    /* Sort objects, return false with exception set on failure */
+    Py_ssize_t n = items.size();
+    std::vector<PyObject*> keys;
+    bool failed = false;
+
+    try
+    {
+        if(keyfunc){
+            keys.reserve(n);
+            for(Py_ssize_t i = 0; i < n; ++i){
+                PyObject *key = PyObject_CallOneArg(keyfunc, items[i]);
+                if(!key){
+                    failed = true;
+                    break;
+                }
+                keys.push_back(key);
+            }
+        }
+
+        if(!failed)
+            sort_items(items.data(), keyfunc ? keys.data() : items.data(),
+                       n, reverse);
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        failed = true;
+    }
+    catch (CompareError)
+    {
+        failed = true;
+    }
+
+    for(PyObject*& key : keys)
+        Py_CLEAR(key);
+
+    return !failed;
+}
+
+
+template<typename T>
+static bool
+sort_unboxed(std::vector<T>& data, PyObject *keyfunc, bool reverse,
+             bool allow_threads)
+{
+    /* Sort raw values, boxing them only when a key function is given
+     * return false with exception set on failure
+     */
+    Py_ssize_t n = data.size();
+    std::vector<PyObject*> items;
+    bool failed = false;
+
+    try
+    {
+        if(!keyfunc && (!allow_threads || n < PARALLEL_MIN_SIZE)){
+            if(reverse)
+                timsort(data.begin(), data.end(), [](T a, T b) {return b < a;});
+            else
+                timsort(data.begin(), data.end(), [](T a, T b) {return a < b;});
+            return true;
+        }
+
+        /* data is private to the sort unless exported, other threads only
+         * see an empty list
+         */
+        if(!keyfunc){
+            Thread_Pool& pool = list_pool();
+            T *values = data.data();
+
+            Py_BEGIN_ALLOW_THREADS
+            try
+            {
+                if(reverse)
+                    parallel_sort(values, n, [](T a, T b) {return b < a;},
+                                  pool, PARALLEL_MIN_SIZE);
+                else
+                    parallel_sort(values, n, [](T a, T b) {return a < b;},
+                                  pool, PARALLEL_MIN_SIZE);
+            }
+            catch (std::bad_alloc)
+            {
+                failed = true;
+            }
+            Py_END_ALLOW_THREADS
+
+            if(failed)
+                PyErr_NoMemory();
+            return !failed;
+        }
+
+        items.reserve(n);
+        for(Py_ssize_t i = 0; i < n && !failed; ++i){
+            PyObject *obj = box_value(data[i]);
+            if(obj)
+                items.push_back(obj);
+            else
+                failed = true;
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        failed = true;
+    }
+
+    if(!failed)
+        failed = !sort_boxed(items, keyfunc, reverse);
+
+    /* boxed values have exactly the storage type, unboxing can not fail */
+    if(!failed)
+        for(Py_ssize_t i = 0; i < n; ++i)
+            unbox_value(items[i], data[i]);
+
+    for(PyObject*& obj : items)
+        Py_CLEAR(obj);
+
+    return !failed;
+}
+
+
+PyObject*
+list_sort(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    PyObject *keyfunc = nullptr;
+    int reverse = 0;
+
+    static char const *kwlist[] = {"key", "reverse", nullptr};
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|$Op:sort",
+                                    const_cast<char**>(kwlist),
+                                    &keyfunc, &reverse))
+        return nullptr;
+
+    if(keyfunc == Py_None)
+        keyfunc = nullptr;
+
+    /* Take the items out, so the list looks empty to key functions
+     * and comparisons which try to mutate it during the sort.
+     * Exported views still see the block, so the GIL is kept then
+     */
+    std::shared_ptr<list_storage> items;
+    list_dtype dtype = _self->dtype;
+    bool allow_threads = _self->exports == 0;
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->lend_storage(items);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    bool sorted = false;
+    switch(dtype)
+    {
+    case INT64_DTYPE:
+        sorted = sort_unboxed(items->int_data, keyfunc, reverse, allow_threads);
+        break;
+    case FLOAT64_DTYPE:
+        sorted = sort_unboxed(items->float_data, keyfunc, reverse,
+                              allow_threads);
+        break;
+    default:
+        sorted = sort_boxed(items->container, keyfunc, reverse);
+    }
+
+    /* Restore items, dropping anything added while sorting
+     * an error raised by the sort itself is kept
+     */
+    if(!_self->return_storage(items, dtype)){
+        if(sorted)
+            PyErr_SetString(PyExc_ValueError, "List modified during sort");
+        return nullptr;
+    }
+
+    if(!sorted)
+        return nullptr;
+
+    Py_RETURN_NONE;
+}
+
+/* Elementwise operations and reductions on typed storage
+ * Work is cut into one range per thread of list_pool(). Reductions read
+ * a reference to the storage block, which writers copy before changing
+ * it, apply_scalar takes the block out of the list like sort does.
+ * With NaN values min and max depend on how the array is cut.
+ */
+template<typename T, typename R, typename Chunk>
+static bool
+reduce_values(T const *data, Py_ssize_t n, bool allow_threads,
+              std::vector<R>& partial, Chunk chunk)
+{
+    /* partial[i] = chunk(first, last) over consecutive ranges of data,
+     * return false with exception set on failure
+     */
+    Thread_Pool& pool = list_pool();
+    std::size_t parts = 1;
+    if(allow_threads && n >= PARALLEL_MIN_SIZE)
+        parts = pool.concurrency();
+
+    try
+    {
+        partial.resize(parts);
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    auto body = [&](std::size_t i)
+    {
+        partial[i] = chunk(data + n * i / parts, data + n * (i + 1) / parts);
+    };
+
+    if(parts == 1){
+        body(0);
+        return true;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pool.parallel_for(parts, body);
+    Py_END_ALLOW_THREADS
+
+    return true;
+}
+
+
+template<typename T, typename Op>
+static void
+apply_values(T *data, Py_ssize_t n, bool allow_threads, Op op)
+{
+    /* data[i] = op(data[i]), without the GIL for large arrays */
+    Thread_Pool& pool = list_pool();
+    std::size_t parts = 1;
+    if(allow_threads && n >= PARALLEL_MIN_SIZE)
+        parts = pool.concurrency();
+
+    auto body = [&](std::size_t i)
+    {
+        T *end = data + n * (i + 1) / parts;
+        for(T *p = data + n * i / parts; p != end; ++p)
+            *p = op(*p);
+    };
+
+    if(parts == 1){
+        body(0);
+        return;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pool.parallel_for(parts, body);
+    Py_END_ALLOW_THREADS
+}
+
+
+static bool
+int64_overflows(std::int64_t const *data, Py_ssize_t n, bool allow_threads,
+                char op, std::int64_t value, bool& overflow)
+{
+    /* overflow = some x op value does not fit int64, read only so nothing
+     * is changed when it does, return false with exception set on failure
+     */
+    std::vector<char> partial;
+    auto check = [op, value](std::int64_t const *first, std::int64_t const *last)
+    {
+        std::int64_t result = 0;
+        bool any = false;
+
+        switch(op)
+        {
+        case '+':
+            for(; first != last; ++first)
+                any |= __builtin_add_overflow(*first, value, &result);
+            break;
+        case '-':
+            for(; first != last; ++first)
+                any |= __builtin_sub_overflow(*first, value, &result);
+            break;
+        default:
+            for(; first != last; ++first)
+                any |= __builtin_mul_overflow(*first, value, &result);
+        }
+        return static_cast<char>(any);
+    };
+
+    if(!reduce_values(data, n, allow_threads, partial, check))
+        return false;
+
+    overflow = std::find(partial.begin(), partial.end(), 1) != partial.end();
+    return true;
+}
+
+
+static void
+apply_int64(std::int64_t *data, Py_ssize_t n, bool allow_threads, char op,
+            std::int64_t value)
+{
+    /* int64_overflows has ruled out overflow, unsigned arithmetic only
+     * keeps the compiler from assuming it
+     */
+    std::uint64_t v = value;
+
+    switch(op)
+    {
+    case '+':
+        apply_values(data, n, allow_threads, [v](std::int64_t x)
+                     {return static_cast<std::int64_t>(static_cast<std::uint64_t>(x) + v);});
+        break;
+    case '-':
+        apply_values(data, n, allow_threads, [v](std::int64_t x)
+                     {return static_cast<std::int64_t>(static_cast<std::uint64_t>(x) - v);});
+        break;
+    default:
+        apply_values(data, n, allow_threads, [v](std::int64_t x)
+                     {return static_cast<std::int64_t>(static_cast<std::uint64_t>(x) * v);});
+    }
+}
+
+
+static void
+apply_float64(double *data, Py_ssize_t n, bool allow_threads, char op,
+              double value)
+{
+    switch(op)
+    {
+    case '+':
+        apply_values(data, n, allow_threads, [value](double x) {return x + value;});
+        break;
+    case '-':
+        apply_values(data, n, allow_threads, [value](double x) {return x - value;});
+        break;
+    case '*':
+        apply_values(data, n, allow_threads, [value](double x) {return x * value;});
+        break;
+    default:
+        apply_values(data, n, allow_threads, [value](double x) {return x / value;});
+    }
+}
+
+
+PyObject*
+list_apply_scalar(PyObject *self, PyObject *args)
+{
+    /* apply_scalar(op, value) replaces each x by x op value in place */
+    ListObject *_self = static_cast<ListObject*>(self);
+    char const *op = nullptr;
+    PyObject *value = nullptr;
+
+    if(!PyArg_ParseTuple(args, "sO:apply_scalar", &op, &value))
+        return nullptr;
+
+    if(std::strlen(op) != 1 || !std::strchr("+-*/", op[0])){
+        PyErr_Format(PyExc_ValueError,
+                     "op must be '+', '-', '*' or '/', not '%s'", op);
+        return nullptr;
+    }
+
+    std::int64_t int_value = 0;
+    double float_value = 0.0;
+
+    switch(_self->dtype)
+    {
+    case INT64_DTYPE:
+        if(op[0] == '/'){
+            PyErr_SetString(PyExc_TypeError,
+                            "'/' needs a List with dtype 'f8'");
+            return nullptr;
+        }
+        if(!PyLong_Check(value)){
+            PyErr_Format(PyExc_TypeError, "List of 'i8' needs int, not %.200s",
+                         Py_TYPE(value)->tp_name);
+            return nullptr;
+        }
+        int_value = PyLong_AsLongLong(value);
+        break;
+
+    case FLOAT64_DTYPE:
+        float_value = PyFloat_AsDouble(value);
+        break;
+
+    default:
+        PyErr_SetString(PyExc_TypeError,
+                        "apply_scalar requires a List with dtype 'i8' or 'f8'");
+        return nullptr;
+    }
+
+    if(PyErr_Occurred())
+        return nullptr;
+
+    /* take the block out, so other threads see an empty list meanwhile,
+     * exported views still see it, so the GIL is kept then
+     */
+    std::shared_ptr<list_storage> block;
+    list_dtype dtype = _self->dtype;
+    bool allow_threads = _self->exports == 0;
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->lend_storage(block);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    if(dtype == INT64_DTYPE){
+        /* results which do not fit int64 raise before anything is written */
+        bool overflow = false;
+        if(!int64_overflows(block->int_data.data(), block->int_data.size(),
+                            allow_threads, op[0], int_value, overflow)
+           || overflow){
+            _self->return_storage(block, dtype);
+            if(overflow)
+                PyErr_SetString(PyExc_OverflowError,
+                                "apply_scalar result does not fit 'i8'");
+            return nullptr;
+        }
+
+        apply_int64(block->int_data.data(), block->int_data.size(),
+                    allow_threads, op[0], int_value);
+    }
+    else
+        apply_float64(block->float_data.data(), block->float_data.size(),
+                      allow_threads, op[0], float_value);
+
+    /* same rules as sort for changes made meanwhile */
+    if(!_self->return_storage(block, dtype)){
+        PyErr_SetString(PyExc_ValueError, "List modified during apply_scalar");
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject*
+call_builtin(char const *name, PyObject *arg)
+{
+    /* object storage is reduced by the builtin of the same name */
+    PyObject *builtin = PyDict_GetItemString(PyEval_GetBuiltins(), name);
+    if(!builtin){
+        PyErr_Format(PyExc_RuntimeError, "builtin %s not found", name);
+        return nullptr;
+    }
+
+    return PyObject_CallOneArg(builtin, arg);
+}
+
+
+struct int64_sum
+{
+    std::int64_t value;
+    bool overflow;
+};
+
+
+PyObject*
+list_sum(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(_self->dtype == OBJECT_DTYPE)
+        return call_builtin("sum", self);
+
+    /* the block stays alive even if the list replaces it meanwhile,
+     * an exported block must stay private so the GIL is kept then
+     */
+    std::shared_ptr<list_storage> block = _self->storage;
+    Py_ssize_t n = _self->getlength();
+    bool allow_threads = _self->exports == 0;
+
+    if(_self->dtype == FLOAT64_DTYPE){
+        std::vector<double> partial;
+        if(!reduce_values(block->float_data.data(), n, allow_threads, partial,
+                          [](double const *first, double const *last)
+                          {
+                              double total = 0.0;
+                              for(; first != last; ++first)
+                                  total += *first;
+                              return total;
+                          }))
+            return nullptr;
+
+        double total = 0.0;
+        for(double value : partial)
+            total += value;
+        return PyFloat_FromDouble(total);
+    }
+
+    std::vector<int64_sum> partial;
+    if(!reduce_values(block->int_data.data(), n, allow_threads, partial,
+                      [](std::int64_t const *first, std::int64_t const *last)
+                      {
+                          int64_sum total{0, false};
+                          for(; first != last && !total.overflow; ++first)
+                              total.overflow = __builtin_add_overflow(
+                                      total.value, *first, &total.value);
+                          return total;
+                      }))
+        return nullptr;
+
+    int64_sum total{0, false};
+    for(int64_sum const& value : partial)
+        if(!total.overflow)
+            total.overflow = value.overflow
+                    || __builtin_add_overflow(total.value, value.value,
+                                              &total.value);
+
+    /* the exact result needs more than 64 bits */
+    if(total.overflow)
+        return call_builtin("sum", self);
+
+    return PyLong_FromLongLong(total.value);
+}
+
+
+template<typename T, typename Better>
+static PyObject*
+extreme_value(T const *data, Py_ssize_t n, bool allow_threads, Better better)
+{
+    /* first value v for which no later value w has better(w, v) */
+    std::vector<T> partial;
+
+    if(!reduce_values(data, n, allow_threads, partial,
+                      [better](T const *first, T const *last)
+                      {
+                          T best = *first;
+                          for(++first; first < last; ++first)
+                              if(better(*first, best))
+                                  best = *first;
+                          return best;
+                      }))
+        return nullptr;
+
+    T best = partial[0];
+    for(T value : partial)
+        if(better(value, best))
+            best = value;
+
+    return box_value(best);
+}
+
+
+PyObject*
+list_extreme(PyObject *self, char const *name, bool maximum)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(_self->getdtype() == OBJECT_DTYPE)
+        return call_builtin(name, self);
+
+    if(_self->getlength() == 0){
+        PyErr_Format(PyExc_ValueError, "%s() arg is an empty List", name);
+        return nullptr;
+    }
+
+    /* see list_sum for the lifetime of the block */
+    std::shared_ptr<list_storage> block = _self->storage;
+    Py_ssize_t n = _self->getlength();
+    bool allow_threads = _self->exports == 0;
+
+    if(_self->getdtype() == INT64_DTYPE){
+        std::int64_t const *data = block->int_data.data();
+        if(maximum)
+            return extreme_value(data, n, allow_threads,
+                                 [](std::int64_t a, std::int64_t b) {return a > b;});
+        return extreme_value(data, n, allow_threads,
+                             [](std::int64_t a, std::int64_t b) {return a < b;});
+    }
+
+    double const *data = block->float_data.data();
+    if(maximum)
+        return extreme_value(data, n, allow_threads,
+                             [](double a, double b) {return a > b;});
+    return extreme_value(data, n, allow_threads,
+                         [](double a, double b) {return a < b;});
+}
+
+
+PyObject*
+list_min(PyObject *self, PyObject*)
+{
+    return list_extreme(self, "min", false);
+}
+
+
+PyObject*
+list_max(PyObject *self, PyObject*)
+{
+    return list_extreme(self, "max", true);
+}
+
+/* Searching
+ * Object storage is first scanned for an item identical to the value,
+ * which needs no Python call at all. Rich comparison only runs on items
+ * in front of the identical one, with native equality when item and
+ * value are both exact float, int or str. Typed storage is searched
+ * on raw values when the value has the storage type.
+ */
+static bool
+unicode_equal(PyObject *a, PyObject *b)
+{
+    /* Both arguments are exact str */
+    Py_ssize_t len = PyUnicode_GET_LENGTH(a);
+    if(len != PyUnicode_GET_LENGTH(b) || PyUnicode_KIND(a) != PyUnicode_KIND(b))
+        return false;
+
+    return std::memcmp(PyUnicode_DATA(a), PyUnicode_DATA(b),
+                       len * PyUnicode_KIND(a)) == 0;
+}
+
+
+static int
+items_equal(PyObject *item, PyObject *value)
+{
+    /* PyObject_RichCompareBool(item, value, Py_EQ) with native fast paths */
+    if(item == value)
+        return 1;
+
+    PyTypeObject *type = Py_TYPE(value);
+    if(Py_TYPE(item) == type){
+        if(type == &PyFloat_Type)
+            return PyFloat_AS_DOUBLE(item) == PyFloat_AS_DOUBLE(value);
+
+        if(type == &PyUnicode_Type)
+            return unicode_equal(item, value);
+
+        if(type == &PyLong_Type){
+            int overflow_item = 0, overflow_value = 0;
+            long long a = PyLong_AsLongLongAndOverflow(item, &overflow_item);
+            long long b = PyLong_AsLongLongAndOverflow(value, &overflow_value);
+            if(!overflow_item && !overflow_value)
+                return a == b;
+        }
+    }
+
+    return PyObject_RichCompareBool(item, value, Py_EQ);
+}
+
+
+static void
+normalize_range(Py_ssize_t length, Py_ssize_t& start, Py_ssize_t& stop)
+{
+    /* Clamp slice-like bounds to [0, length] */
+    if(start < 0){
+        start += length;
+        if(start < 0)
+            start = 0;
+    }
+
+    if(stop < 0){
+        stop += length;
+        if(stop < 0)
+            stop = 0;
+    }
+
+    if(stop > length)
+        stop = length;
+}
+
+
+template<typename Seq>
+static Py_ssize_t
+find_equal(Seq *self, PyObject *value, Py_ssize_t start, Py_ssize_t stop)
+{
+    /* Generic search, items may mutate the list from __eq__ */
+    for(Py_ssize_t i = start; i < stop && self->is_open() && i < self->getlength(); ++i){
+        int status = 0;
+        PyObject *item = nullptr;
+
+        std::tie(status, item) = self->getter(i);
+        if(status == ERROR){
+            set_status_error(item);
+            return -2;
+        }
+
+        int result = items_equal(item, value);
+        Py_DECREF(item);
+
+        if(result < 0)
+            return -2;
+        if(result)
+            return i;
+    }
+
+    return -1;
+}
+
+
+template<typename Seq>
+static Py_ssize_t
+typed_find(Seq *self, PyObject *value, Py_ssize_t start, Py_ssize_t stop)
+{
+    /* list_find for typed storage of a List or a MappedList
+     * raw values are searched with SIMD when value has the storage type
+     */
+    if(self->getdtype() == INT64_DTYPE && typed_accepts(INT64_DTYPE, value)){
+        std::uint64_t key = PyLong_AsLongLong(value);
+        auto data = static_cast<std::uint64_t const*>(self->typed_data());
+        Py_ssize_t pos = start + simd_search::find(data + start, stop - start, key);
+        return pos < stop ? pos : -1;
+    }
+
+    if(self->getdtype() == FLOAT64_DTYPE && typed_accepts(FLOAT64_DTYPE, value)){
+        double key = PyFloat_AS_DOUBLE(value);
+        auto data = static_cast<double const*>(self->typed_data());
+        Py_ssize_t pos = start + simd_search::find(data + start, stop - start, key);
+        return pos < stop ? pos : -1;
+    }
+
+    return find_equal(self, value, start, stop);
+}
+
+
+Py_ssize_t
+list_find(ListObject *self, PyObject *value, Py_ssize_t start,
+          Py_ssize_t stop)
+{
+    /* return index of the first item equal to value in [start, stop)
+     * -1 if there is none, -2 with exception set on error
+     */
+    normalize_range(self->getlength(), start, stop);
+    if(start >= stop)
+        return -1;
+
+    if(self->dtype != OBJECT_DTYPE)
+        return typed_find(self, value, start, stop);
+
+    PyObject* const* data = self->storage->container.data();
+    Py_ssize_t hit = start + simd_search::find_pointer(data + start,
+                                                       stop - start, value);
+
+    /* an item in front of the identical one may still compare equal */
+    Py_ssize_t pos = find_equal(self, value, start, hit);
+    if(pos != -1 || hit == stop)
+        return pos;
+
+    /* __eq__ may have moved the identical item, search again if so */
+    if(self->dtype == OBJECT_DTYPE && hit < self->getlength()
+            && self->storage->container[hit] == value)
+        return hit;
+
+    return find_equal(self, value, hit, stop);
+}
+
+
+bool
+list_find_identical(ListObject *self, PyObject *value)
+{
+    /* whether object storage holds value itself */
+    PyObject* const* data = self->storage->container.data();
+    Py_ssize_t n = self->storage->container.size();
+    return simd_search::find_pointer(data, n, value) < n;
+}
+
+
+Py_ssize_t
+list_count_value(ListObject *self, PyObject *value)
+{
+    /* return number of items equal to value, -1 with exception set on error */
+    Py_ssize_t n = self->getlength();
+
+    if(self->dtype == INT64_DTYPE && self->accepts(value)){
+        std::uint64_t key = PyLong_AsLongLong(value);
+        auto data = reinterpret_cast<std::uint64_t const*>(self->storage->int_data.data());
+        return simd_search::count(data, n, key);
+    }
+
+    if(self->dtype == FLOAT64_DTYPE && self->accepts(value))
+        return simd_search::count(self->storage->float_data.data(), n,
+                                  PyFloat_AS_DOUBLE(value));
+
+    Py_ssize_t result = 0;
+    for(Py_ssize_t i = 0; i < self->getlength(); ++i){
+        /* identical items need neither a new reference nor __eq__ */
+        if(self->dtype == OBJECT_DTYPE && self->storage->container[i] == value){
+            ++result;
+            continue;
+        }
+
+        int status = 0;
+        PyObject *item = nullptr;
+
+        std::tie(status, item) = self->getter(i);
+        if(status == ERROR){
+            PyErr_SetNone(item);
+            return -1;
+        }
+
+        int equal = items_equal(item, value);
+        Py_DECREF(item);
+
+        if(equal < 0)
+            return -1;
+        result += equal;
+    }
+
+    return result;
+}
+
+
+int
+list_contains(PyObject *self, PyObject *value)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    /* membership does not care about position, an identical item is enough */
+    if(_self->getdtype() == OBJECT_DTYPE && list_find_identical(_self, value))
+        return 1;
+
+    Py_ssize_t pos = list_find(_self, value, 0, PY_SSIZE_T_MAX);
+    if(pos == -2)
+        return -1;
+
+    return pos >= 0;
+}
+
+
+PyObject*
+list_index(PyObject *self, PyObject *args)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    PyObject *value = nullptr;
+    Py_ssize_t start = 0;
+    Py_ssize_t stop = PY_SSIZE_T_MAX;
+
+    if(!PyArg_ParseTuple(args, "O|nn:index", &value, &start, &stop))
+        return nullptr;
+
+    Py_ssize_t pos = list_find(_self, value, start, stop);
+    if(pos == -2)
+        return nullptr;
+
+    if(pos == -1){
+        PyErr_Format(PyExc_ValueError, "%R is not in List", value);
+        return nullptr;
+    }
+
+    return PyLong_FromSsize_t(pos);
+}
+
+
+PyObject*
+list_count(PyObject *self, PyObject *value)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    Py_ssize_t result = list_count_value(_self, value);
+    if(result < 0)
+        return nullptr;
+
+    return PyLong_FromSsize_t(result);
+}
+
+/* Comparison
+ * Lists compare like builtin lists: the first position where items
+ * differ decides, the lengths decide when there is none. == and != check
+ * the lengths first, identical items are equal without calling __eq__,
+ * and two typed lists of the same dtype compare raw values.
+ */
+template<typename T>
+static Py_ssize_t
+first_difference(T const *a, T const *b, Py_ssize_t n)
+{
+    /* memcmp finds equal integer arrays fastest, NaN rules out floats */
+    if constexpr(std::is_integral_v<T>)
+        if(n > 0 && std::memcmp(a, b, n * sizeof(T)) == 0)
+            return n;
+
+    Py_ssize_t i = 0;
+    while(i < n && a[i] == b[i])
+        ++i;
+    return i;
+}
+
+
+template<typename T>
+static PyObject*
+compare_values(std::vector<T> const& a, std::vector<T> const& b, int op)
+{
+    Py_ssize_t len_a = a.size(), len_b = b.size();
+    Py_ssize_t n = len_a < len_b ? len_a : len_b;
+
+    Py_ssize_t i = first_difference(a.data(), b.data(), n);
+    if(i == n)
+        Py_RETURN_RICHCOMPARE(len_a, len_b, op);
+
+    if(op == Py_EQ)
+        Py_RETURN_FALSE;
+    if(op == Py_NE)
+        Py_RETURN_TRUE;
+
+    Py_RETURN_RICHCOMPARE(a[i], b[i], op);
+}
+
+
+PyObject*
+list_richcompare(PyObject *self, PyObject *other, int op)
+{
+    if(!PyObject_TypeCheck(other, &ListType))
+        Py_RETURN_NOTIMPLEMENTED;
+
+    ListObject *a = static_cast<ListObject*>(self);
+    ListObject *b = static_cast<ListObject*>(other);
+
+    /* Every item is identical to itself, so like the builtin list only the
+     * lengths decide, whatever the storage (l == l holds with NaN in 'f8')
+     */
+    if(a == b)
+        Py_RETURN_RICHCOMPARE(a->getlength(), b->getlength(), op);
+
+    if((op == Py_EQ || op == Py_NE) && a->getlength() != b->getlength()){
+        if(op == Py_EQ)
+            Py_RETURN_FALSE;
+        Py_RETURN_TRUE;
+    }
+
+    if(a->dtype == b->dtype && a->dtype == INT64_DTYPE)
+        return compare_values(a->storage->int_data, b->storage->int_data, op);
+
+    if(a->dtype == b->dtype && a->dtype == FLOAT64_DTYPE)
+        return compare_values(a->storage->float_data, b->storage->float_data, op);
+
+    /* __eq__ may change both lists, bounds are checked on every step */
+    for(Py_ssize_t i = 0; i < a->getlength() && i < b->getlength(); ++i){
+        if(a->dtype == OBJECT_DTYPE && b->dtype == OBJECT_DTYPE
+                && a->storage->container[i] == b->storage->container[i])
+            continue;
+
+        int status = 0;
+        PyObject *x = nullptr, *y = nullptr;
+
+        std::tie(status, x) = a->getter(i);
+        if(status == ERROR){
+            PyErr_SetNone(x);
+            return nullptr;
+        }
+
+        std::tie(status, y) = b->getter(i);
+        if(status == ERROR){
+            Py_DECREF(x);
+            PyErr_SetNone(y);
+            return nullptr;
+        }
+
+        int equal = items_equal(x, y);
+        PyObject *result = nullptr;
+
+        if(equal == 0){
+            if(op == Py_EQ)
+                result = Py_NewRef(Py_False);
+            else if(op == Py_NE)
+                result = Py_NewRef(Py_True);
+            else
+                result = PyObject_RichCompare(x, y, op);
+        }
+
+        Py_DECREF(x);
+        Py_DECREF(y);
+
+        if(equal != 1)
+            return result;
+    }
+
+    Py_RETURN_RICHCOMPARE(a->getlength(), b->getlength(), op);
+}
+
+/* Batch removal
+ * pop(count) moves the tail to a new List, del_indices and retain mark
+ * the items to remove and compact the storage once, so removing k of
+ * n items costs O(n) instead of O(k * n) through the deleter.
+ */
+PyObject*
+list_pop(PyObject *self, PyObject *args)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    PyObject *count_obj = Py_None;
+
+    if(!PyArg_UnpackTuple(args, "pop", 0, 1, &count_obj))
+        return nullptr;
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    /* pop() returns the last item */
+    if(count_obj == Py_None){
+        Py_ssize_t last = _self->getlength() - 1;
+        if(last < 0){
+            PyErr_SetString(PyExc_IndexError, "pop from empty List");
+            return nullptr;
+        }
+
+        PyObject *value = nullptr;
+        std::tie(status, value) = _self->getter(last);
+        if(status == ERROR){
+            PyErr_SetNone(value);
+            return nullptr;
+        }
+
+        std::tie(status, error) = _self->deleter(last);
+        if(status == ERROR){
+            Py_DECREF(value);
+            PyErr_SetNone(error);
+            return nullptr;
+        }
+
+        return value;
+    }
+
+    /* pop(count) returns a List of the last count items, in order */
+    Py_ssize_t count = PyNumber_AsSsize_t(count_obj, PyExc_OverflowError);
+    if(count == -1 && PyErr_Occurred())
+        return nullptr;
+
+    if(count < 0){
+        PyErr_SetString(PyExc_ValueError, "pop count must not be negative");
+        return nullptr;
+    }
+
+    if(count > _self->getlength()){
+        PyErr_SetString(PyExc_IndexError, "pop count larger than List");
+        return nullptr;
+    }
+
+    ListObject *result = nullptr;
+
+    try
+    {
+        result = new ListObject{};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+    Py_INCREF(result);
+
+    result->dtype = _self->dtype;
+    std::tie(status, error) = _self->pop_tail(count, result);
+    if(status == ERROR){
+        Py_DECREF(result);
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    return static_cast<PyObject*>(result);
+}
+
+
+PyObject*
+list_del_indices(PyObject *self, PyObject *indices)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    /* Collect every index first, iterating may run Python code */
+    PyObject *iter = PyObject_GetIter(indices);
+    if(!iter)
+        return nullptr;
+
+    std::vector<Py_ssize_t> positions;
+    PyObject *item = nullptr;
+
+    while((item = PyIter_Next(iter))){
+        Py_ssize_t index = PyNumber_AsSsize_t(item, PyExc_IndexError);
+        Py_DECREF(item);
+
+        if(index == -1 && PyErr_Occurred())
+            break;
+
+        try
+        {
+            positions.push_back(index);
+        }
+        catch (std::bad_alloc)
+        {
+            PyErr_NoMemory();
+            break;
+        }
+    }
+
+    Py_DECREF(iter);
+    if(PyErr_Occurred())
+        return nullptr;
+
+    /* Nothing is removed unless every index is valid */
+    Py_ssize_t length = _self->getlength();
+    std::vector<char> remove;
+
+    try
+    {
+        remove.assign(length, 0);
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    for(Py_ssize_t index : positions){
+        if(index < 0)
+            index += length;
+
+        if(index < 0 || index >= length){
+            PyErr_SetString(PyExc_IndexError, "List index out of range");
+            return nullptr;
+        }
+
+        remove[index] = 1;
+    }
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->compact(remove);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+list_retain(PyObject *self, PyObject *predicate)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    /* Keep the items for which predicate(item) is true */
+    Py_ssize_t length = _self->getlength();
+    Py_ssize_t version = _self->getversion();
+    std::vector<char> remove;
+
+    try
+    {
+        remove.assign(length, 0);
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    for(Py_ssize_t i = 0; i < length; ++i){
+        PyObject *value = _self->item(i);
+        if(!value)
+            return nullptr;
+
+        PyObject *keep = PyObject_CallOneArg(predicate, value);
+        Py_DECREF(value);
+        if(!keep)
+            return nullptr;
+
+        int truth = PyObject_IsTrue(keep);
+        Py_DECREF(keep);
+        if(truth < 0)
+            return nullptr;
+
+        if(_self->getversion() != version){
+            PyErr_SetString(PyExc_RuntimeError,
+                            "List changed size during retain");
+            return nullptr;
+        }
+
+        remove[i] = !truth;
+    }
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->compact(remove);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+/* Reordering
+ * reverse, rotate and permute move items inside the storage block, the
+ * length stays the same and nothing is reallocated. permute follows each
+ * cycle of the permutation once, with one flag per item as extra memory.
+ */
+PyObject*
+list_reverse(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->reverse();
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+list_rotate(PyObject *self, PyObject *args)
+{
+    /* rotate(k) moves the last k items to the front, like deque.rotate */
+    ListObject *_self = static_cast<ListObject*>(self);
+    Py_ssize_t k = 1;
+
+    if(!PyArg_ParseTuple(args, "|n:rotate", &k))
+        return nullptr;
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->rotate(k);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+list_permute(PyObject *self, PyObject *order)
+{
+    /* permute(order) moves the item at order[i] to position i */
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    /* Collect every index first, iterating may run Python code */
+    PyObject *iter = PyObject_GetIter(order);
+    if(!iter)
+        return nullptr;
+
+    std::vector<Py_ssize_t> positions;
+    PyObject *item = nullptr;
+
+    while((item = PyIter_Next(iter))){
+        Py_ssize_t index = PyNumber_AsSsize_t(item, PyExc_IndexError);
+        Py_DECREF(item);
+
+        if(index == -1 && PyErr_Occurred())
+            break;
+
+        try
+        {
+            positions.push_back(index);
+        }
+        catch (std::bad_alloc)
+        {
+            PyErr_NoMemory();
+            break;
+        }
+    }
+
+    Py_DECREF(iter);
+    if(PyErr_Occurred())
+        return nullptr;
+
+    Py_ssize_t length = _self->getlength();
+    if(static_cast<Py_ssize_t>(positions.size()) != length){
+        PyErr_Format(PyExc_ValueError,
+                     "permute needs %zd indices, got %zd",
+                     length, static_cast<Py_ssize_t>(positions.size()));
+        return nullptr;
+    }
+
+    for(Py_ssize_t& index : positions){
+        if(index < 0)
+            index += length;
+
+        if(index < 0 || index >= length){
+            PyErr_SetString(PyExc_IndexError, "List index out of range");
+            return nullptr;
+        }
+    }
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->permute(positions);
+    if(status == ERROR){
+        if(error == PyExc_ValueError)
+            PyErr_SetString(error, "permute indices must not repeat");
+        else
+            PyErr_SetNone(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+/* Serialization
+ * Typed lists travel as their raw native-endian array, object lists as
+ * a builtin list which List() copies in one block. The module is named
+ * in tp_name so pickle can find List again.
+ */
+PyObject*
+list_reduce(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    if(_self->getdtype() != OBJECT_DTYPE){
+        PyObject *from_bytes = PyObject_GetAttrString((PyObject*) &ListType,
+                                                      "from_bytes");
+        if(!from_bytes)
+            return nullptr;
+
+        PyObject *data = list_to_bytes(self, nullptr);
+        if(!data){
+            Py_DECREF(from_bytes);
+            return nullptr;
+        }
+
+        char const *dtype = _self->getdtype() == INT64_DTYPE ? "i8" : "f8";
+        return Py_BuildValue("N(Ns)", from_bytes, data, dtype);
+    }
+
+    Py_ssize_t n = _self->getlength();
+    PyObject *items = PyList_New(n);
+    if(!items)
+        return nullptr;
+
+    for(Py_ssize_t i = 0; i < n; ++i)
+        PyList_SET_ITEM(items, i, _self->item(i));
+
+    return Py_BuildValue("O(N)", (PyObject*) &ListType, items);
+}
+
+
+PyObject*
+list_to_bytes(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    switch(_self->dtype)
+    {
+    case INT64_DTYPE:
+        return PyBytes_FromStringAndSize(
+                reinterpret_cast<char const*>(_self->storage->int_data.data()),
+                _self->getlength() * sizeof(std::int64_t));
+
+    case FLOAT64_DTYPE:
+        return PyBytes_FromStringAndSize(
+                reinterpret_cast<char const*>(_self->storage->float_data.data()),
+                _self->getlength() * sizeof(double));
+
+    default:
+        PyErr_SetString(PyExc_TypeError,
+                        "to_bytes requires a List with dtype 'i8' or 'f8'");
+        return nullptr;
+    }
+}
+
+
+PyObject*
+list_from_bytes(PyObject*, PyObject *args, PyObject *kwargs)
+{
+    /* List.from_bytes(data, dtype), data is any contiguous buffer */
+    Py_buffer view;
+    char const *dtype = nullptr;
+
+    static char const *kwlist[] = {"data", "dtype", nullptr};
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "y*s:from_bytes",
+                                    const_cast<char**>(kwlist),
+                                    &view, &dtype))
+        return nullptr;
+
+    list_dtype new_dtype = OBJECT_DTYPE;
+    if(!parse_dtype(dtype, new_dtype) || new_dtype == OBJECT_DTYPE){
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError,
+                            "from_bytes requires dtype 'i8' or 'f8'");
+        PyBuffer_Release(&view);
+        return nullptr;
+    }
+
+    if(view.len % 8 != 0){
+        PyErr_SetString(PyExc_ValueError,
+                        "buffer length must be a multiple of 8");
+        PyBuffer_Release(&view);
+        return nullptr;
+    }
+
+    Py_ssize_t n = view.len / 8;
+    ListObject *result = nullptr;
+
+    /* storage is sized once and filled with a single copy */
+    try
+    {
+        result = new ListObject{};
+        result->dtype = new_dtype;
+
+        if(new_dtype == INT64_DTYPE){
+            result->storage->int_data.resize(n);
+            std::memcpy(result->storage->int_data.data(), view.buf, view.len);
+        } else {
+            result->storage->float_data.resize(n);
+            std::memcpy(result->storage->float_data.data(), view.buf, view.len);
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        delete result;
+        PyBuffer_Release(&view);
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    PyBuffer_Release(&view);
+    Py_INCREF(result);
+    return static_cast<PyObject*>(result);
+}
+
+/* Implementation of ListView */
+ListViewObject::ListViewObject(ListObject *_list, Py_ssize_t _start,
+                               Py_ssize_t _step, Py_ssize_t _length)
+        : PyObject{0, &ListViewType}, list{_list},
+          start{_start}, step{_step}, length{_length},
+          version{_list->getversion()}
+{
+    Py_INCREF(this->list);
+}
+
+
+ListViewObject::~ListViewObject()
+{
+    assert(this->list == nullptr 
+            && "ListViewObject is not cleared before deconstructed"); 
+}
+
+
+bool
+ListViewObject::is_valid() const
+{
+    /* the list must not have been resized, and must still hold the items
+     * (it looks empty while being sorted)
+     */
+    if(this->version != this->list->getversion())
+        return false;
+
+    if(this->length == 0)
+        return true;
+
+    Py_ssize_t last = this->parent_index(this->length - 1);
+    Py_ssize_t highest = last > this->start ? last : this->start;
+    return highest < this->list->getlength();
+}
+
+
+static bool
+check_view(ListViewObject *view)
+{
+    if(view->is_valid())
+        return true;
+
+    PyErr_SetString(PyExc_RuntimeError,
+                    "List changed size, ListView is no longer valid");
+    return false;
+}
+
+
+void
+listview_dealloc(PyObject *self)
+{
+    ListViewObject *_self = static_cast<ListViewObject*>(self);
+    Py_CLEAR(_self->list);
+    delete _self;
+}
+
+
+Py_ssize_t
+listview_length(PyObject *self)
+{
+    ListViewObject *_self = static_cast<ListViewObject*>(self);
+
+    if(!check_view(_self))
+        return -1;
+
+    return _self->length;
+}
+
+
+PyObject*
+listview_getitem(PyObject *self, Py_ssize_t index)
+{
+    ListViewObject *_self = static_cast<ListViewObject*>(self);
+
+    if(!check_view(_self))
+        return nullptr;
+
+    if(index < 0 || index >= _self->length){
+        PyErr_SetNone(PyExc_IndexError);
+        return nullptr;
+    }
+
+    return _self->list->item(_self->parent_index(index));
+}
+
+
+int
+listview_setitem(PyObject *self, Py_ssize_t index, PyObject *value)
+{
+    ListViewObject *_self = static_cast<ListViewObject*>(self);
+
+    if(!value){
+        PyErr_SetString(PyExc_TypeError, "ListView does not support deletion");
+        return -1;
+    }
+
+    if(!check_view(_self))
+        return -1;
+
+    if(index < 0 || index >= _self->length){
+        PyErr_SetNone(PyExc_IndexError);
+        return -1;
+    }
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->list->setter(_self->parent_index(index),
+                                                  value);
+    if(status == ERROR){
+        PyErr_SetNone(error);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+PyObject*
+list_view(PyObject *self, PyObject *args)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    /* Arguments follow slice(start, stop, step) */
+    PyObject *start = Py_None;
+    PyObject *stop = Py_None;
+    PyObject *step = Py_None;
+
+    if(!PyArg_UnpackTuple(args, "view", 0, 3, &start, &stop, &step))
+        return nullptr;
+
+    PyObject *slice = PySlice_New(start, stop, step);
+    if(!slice)
+        return nullptr;
+
+    Py_ssize_t _start = 0, _stop = 0, _step = 0;
+    int unpacked = PySlice_Unpack(slice, &_start, &_stop, &_step);
+    Py_DECREF(slice);
+
+    if(unpacked < 0)
+        return nullptr;
+
+    Py_ssize_t length = PySlice_AdjustIndices(_self->getlength(),
+                                              &_start, &_stop, _step);
+    ListViewObject *viewobj = nullptr;
+
+    try
+    {
+        viewobj = new ListViewObject{_self, _start, _step, length};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(viewobj);
+    return static_cast<PyObject*>(viewobj);
+}
+
+/* Implemetation of iterator protocol */
+PyObject*
+list_iter(PyObject *self)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    ListIterObject *iterobj = nullptr;
+
+    try
+    {
+        iterobj = new ListIterObject{_self, &ListIterType, 0};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(iterobj);
+    return static_cast<PyObject*>(iterobj);
+}
+
+
+PyObject*
+list_reversed(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    ListIterObject *iterobj = nullptr;
+
+    try
+    {
+        iterobj = new ListIterObject{_self, &ListRevIterType,
+                                     _self->getlength() - 1};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(iterobj);
+    return static_cast<PyObject*>(iterobj);
+}
+
+
+PyObject*
+list_copy(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    ListObject *listobj = nullptr;
+
+    try
+    {
+        listobj = new ListObject{};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(listobj);
+    listobj->dtype = _self->dtype;
+    listobj->storage = _self->storage;
+
+    /* a block exported through the buffer protocol stays private */
+    if(_self->exports > 0){
+        int status = 0;
+        PyObject *error = nullptr;
+
+        std::tie(status, error) = listobj->unshare();
+        if(status == ERROR){
+            Py_DECREF(listobj);
+            PyErr_SetNone(error);
+            return nullptr;
+        }
+    }
+
+    return static_cast<PyObject*>(listobj);
+}
+
+
+PyObject*
+list_snapshot(PyObject *self, PyObject*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    ListSnapshotIterObject *iterobj = nullptr;
+
+    try
+    {
+        std::shared_ptr<list_storage> storage = _self->storage;
+
+        /* a block exported through the buffer protocol stays private */
+        if(_self->exports > 0)
+            storage = std::make_shared<list_storage>(*storage);
+
+        iterobj = new ListSnapshotIterObject{std::move(storage), _self->dtype,
+                                             _self->getlength()};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(iterobj);
+    return static_cast<PyObject*>(iterobj);
+}
+
+
+PyObject*
+listiter_iter(PyObject *self)
+{
+    Py_INCREF(self);
+    return self;
+}
+
+
+PyObject*
+list_iternext(PyObject *self)
+{
+    ListIterObject *_self = static_cast<ListIterObject*>(self);
+    ListObject *list = _self->list;
+
+    if(!list)
+        return nullptr;
+
+    Py_ssize_t pos = _self->currentpos;
+    if(pos < list->getlength()){
+        _self->currentpos = pos + 1;
+        return list->item(pos);
+    }
+
+    Py_CLEAR(_self->list);
+    return nullptr;
+}
+
+
+PyObject*
+list_reviternext(PyObject *self)
+{
+    ListIterObject *_self = static_cast<ListIterObject*>(self);
+    ListObject *list = _self->list;
+
+    if(!list)
+        return nullptr;
+
+    /* the list may have shrunk since the previous step */
+    Py_ssize_t pos = _self->currentpos;
+    if(pos >= 0 && pos < list->getlength()){
+        _self->currentpos = pos - 1;
+        return list->item(pos);
+    }
+
+    Py_CLEAR(_self->list);
+    return nullptr;
+}
+
+
+PyObject*
+list_snapshotnext(PyObject *self)
+{
+    ListSnapshotIterObject *_self = static_cast<ListSnapshotIterObject*>(self);
+
+    if(!_self->storage)
+        return nullptr;
+
+    Py_ssize_t pos = _self->currentpos;
+    if(pos < _self->length){
+        _self->currentpos = pos + 1;
+        return _self->storage->item(_self->dtype, pos);
+    }
+
+    _self->storage.reset();
+    return nullptr;
+}
+
+
+PyObject*
+listiter_length_hint(PyObject *self, PyObject*)
+{
+    ListIterObject *_self = static_cast<ListIterObject*>(self);
+    Py_ssize_t remaining = 0;
+
+    if(_self->list)
+        remaining = _self->list->getlength() - _self->currentpos;
+
+    return PyLong_FromSsize_t(remaining > 0 ? remaining : 0);
+}
+
+
+PyObject*
+listreviter_length_hint(PyObject *self, PyObject*)
+{
+    ListIterObject *_self = static_cast<ListIterObject*>(self);
+    Py_ssize_t remaining = 0;
+
+    if(_self->list && _self->currentpos < _self->list->getlength())
+        remaining = _self->currentpos + 1;
+
+    return PyLong_FromSsize_t(remaining);
+}
+
+
+PyObject*
+listsnapshot_length_hint(PyObject *self, PyObject*)
+{
+    ListSnapshotIterObject *_self = static_cast<ListSnapshotIterObject*>(self);
+    Py_ssize_t remaining = 0;
+
+    if(_self->storage)
+        remaining = _self->length - _self->currentpos;
+
+    return PyLong_FromSsize_t(remaining);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::getter(Py_ssize_t index)
+{
+    /* return a new reference, typed storage is boxed here */
+    if(index < 0 || index >= this->getlength())
+        return std::make_tuple(ERROR, PyExc_IndexError);
+
+    PyObject *value = this->item(index);
+    if(!value)
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+
+    return std::make_tuple(SUCCESS, value);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::setter(Py_ssize_t index, PyObject *value)
+{
+    /* Check validity of index */
+    if(index < 0 || index >= this->getlength())
+        return std::make_tuple(ERROR, PyExc_IndexError);
+
+    if(!this->accepts(value)){
+        auto result = this->to_object_storage();
+        if(std::get<0>(result) == ERROR)
+            return result;
+    }
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    /* Store raw value when storage type allows it */
+    if(this->dtype == INT64_DTYPE){
+        this->storage->int_data[index] = PyLong_AsLongLong(value);
+        return std::make_tuple(SUCCESS, nullptr);
+    }
+
+    if(this->dtype == FLOAT64_DTYPE){
+        this->storage->float_data[index] = PyFloat_AS_DOUBLE(value);
+        return std::make_tuple(SUCCESS, nullptr);
+    }
+
+    /* Change existing values stored at index */
+    PyObject *old_value = this->storage->container[index];
+    Py_INCREF(value);
+    this->storage->container[index] = value;
+    Py_DECREF(old_value);
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::deleter(Py_ssize_t index)
+{
+    /* Check validity of index */
+    if(index < 0 || index >= this->getlength())
+        return std::make_tuple(ERROR, PyExc_IndexError);
+
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    /* Delete item and shift list items after it */
+    PyObject *old_value = nullptr;
+
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        this->storage->int_data.erase(this->storage->int_data.begin() + index);
+        break;
+
+    case FLOAT64_DTYPE:
+        this->storage->float_data.erase(this->storage->float_data.begin() + index);
+        break;
+
+    default:
+        old_value = this->storage->container[index];
+        this->storage->container.erase(this->storage->container.begin() + index);
+    }
+
+    this->version += 1;
+    this->shrink_storage();
+
+    Py_XDECREF(old_value);
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::inserter(Py_ssize_t index, PyObject *value)
+{
     /* Check validity of index */
+    if(index < 0 || index > this->getlength())
+        return std::make_tuple(ERROR, PyExc_IndexError);
+
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    if(!this->accepts(value)){
+        auto result = this->to_object_storage();
+        if(std::get<0>(result) == ERROR)
+            return result;
+    }
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    try
+    {
+        switch(this->dtype)
+        {
+        case INT64_DTYPE:
+            this->storage->int_data.insert(this->storage->int_data.begin() + index,
+                                  PyLong_AsLongLong(value));
+            break;
+
+        case FLOAT64_DTYPE:
+            this->storage->float_data.insert(this->storage->float_data.begin() + index,
+                                    PyFloat_AS_DOUBLE(value));
+            break;
+
+        default:
+            this->storage->container.insert(this->storage->container.begin() + index, value);
+            Py_INCREF(value);
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    this->version += 1;
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::appender(PyObject *value)
+{
+    /* Fast version of inserter(getlength(), value) */
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    if(!this->accepts(value)){
+        auto result = this->to_object_storage();
+        if(std::get<0>(result) == ERROR)
+            return result;
+    }
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    try
+    {
+        switch(this->dtype)
+        {
+        case INT64_DTYPE:
+            this->storage->int_data.push_back(PyLong_AsLongLong(value));
+            break;
+
+        case FLOAT64_DTYPE:
+            this->storage->float_data.push_back(PyFloat_AS_DOUBLE(value));
+            break;
+
+        default:
+            this->storage->container.push_back(value);
+            Py_INCREF(value);
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    this->version += 1;
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+static inline void
+incref_n(PyObject *obj, Py_ssize_t n)
+{
+    /* Py_INCREF repeated n times, in a single store */
+#ifdef Py_REF_DEBUG
+    for(Py_ssize_t i = 0; i < n; ++i)
+        Py_INCREF(obj);
+#else
+    Py_SET_REFCNT(obj, Py_REFCNT(obj) + n);
+#endif
+}
+
+
+template<typename T>
+static void
+copy_block(std::vector<T>& dest, T const *src, Py_ssize_t n)
+{
+    /* Append n trivially copyable values with memcpy
+     * src may point into dest when enough capacity is reserved
+     */
+    Py_ssize_t old_size = dest.size();
+    dest.resize(old_size + n);
+    if(n > 0)
+        std::memcpy(dest.data() + old_size, src, n * sizeof(T));
+}
+
+
+template<typename T>
+static void
+repeat_block(std::vector<T>& data, Py_ssize_t count)
+{
+    /* Grow data to count copies of itself by doubling memcpy
+     * may throw bad_alloc, data is unchanged in that case
+     */
+    Py_ssize_t block = data.size();
+    if(block > static_cast<Py_ssize_t>(data.max_size()) / count)
+        throw std::bad_alloc{};
+
+    Py_ssize_t total = block * count;
+    data.reserve(total);
+
+    Py_ssize_t done = block;
+    while(done < total){
+        Py_ssize_t chunk = done < total - done ? done : total - done;
+        copy_block(data, data.data(), chunk);
+        done += chunk;
+    }
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::extend_from(ListObject *other)
+{
+    /* Append all items of other (which may be this) with a single
+     * reservation, whole blocks are copied when storage types match
+     */
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    Py_ssize_t old_size = this->getlength();
+    Py_ssize_t n = other->getlength();
+
+    try
+    {
+        this->reserve(old_size + n);
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    /* capacity is reserved, so neither copy below reallocates */
+    if(this->dtype == other->dtype){
+        switch(this->dtype)
+        {
+        case INT64_DTYPE:
+            copy_block(this->storage->int_data, other->storage->int_data.data(), n);
+            break;
+
+        case FLOAT64_DTYPE:
+            copy_block(this->storage->float_data, other->storage->float_data.data(), n);
+            break;
+
+        default:
+            copy_block(this->storage->container, other->storage->container.data(), n);
+            for(Py_ssize_t i = old_size; i < old_size + n; ++i)
+                Py_INCREF(this->storage->container[i]);
+        }
+
+        this->version += 1;
+        return std::make_tuple(SUCCESS, nullptr);
+    }
+
+    /* Storage differs, box (if needed) and append item by item */
+    for(Py_ssize_t i = 0; i < n; ++i){
+        PyObject *value = other->item(i);
+        if(!value)
+            return std::make_tuple(ERROR, PyExc_MemoryError);
+
+        auto result = this->appender(value);
+        Py_DECREF(value);
+        if(std::get<0>(result) == ERROR)
+            return result;
+    }
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::repeat(Py_ssize_t count)
+{
+    /* Replace content by count copies of it, in place */
+    if(count <= 0)
+        return this->clear();
+
+    Py_ssize_t size = this->getlength();
+    if(count == 1 || size == 0)
+        return std::make_tuple(SUCCESS, nullptr);
+
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    if(size > PY_SSIZE_T_MAX / count)
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    try
+    {
+        switch(this->dtype)
+        {
+        case INT64_DTYPE:
+            repeat_block(this->storage->int_data, count);
+            break;
+
+        case FLOAT64_DTYPE:
+            repeat_block(this->storage->float_data, count);
+            break;
+
+        default:
+            repeat_block(this->storage->container, count);
+            for(Py_ssize_t i = 0; i < size; ++i)
+                incref_n(this->storage->container[i], count - 1);
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    this->version += 1;
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::to_object_storage()
+{
+    /* Box every raw value, the list keeps object storage afterwards */
+    if(this->dtype == OBJECT_DTYPE)
+        return std::make_tuple(SUCCESS, nullptr);
+
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    /* boxed items go to a new block, a shared block is left untouched */
+    Py_ssize_t n = this->getlength();
+    std::shared_ptr<list_storage> boxed;
+
+    try
+    {
+        boxed = std::make_shared<list_storage>();
+        boxed->container.reserve(n);
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    for(Py_ssize_t i = 0; i < n; ++i){
+        int status = 0;
+        PyObject *obj = nullptr;
+
+        std::tie(status, obj) = this->getter(i);
+        if(status == ERROR)
+            return std::make_tuple(ERROR, obj);
+
+        boxed->container.push_back(obj);
+    }
+
+    this->storage.swap(boxed);
+    this->dtype = OBJECT_DTYPE;
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::clear()
+{
+    /* Remove all items, storage type is kept */
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    /* the old block is released after the list is consistent again,
+     * it is only freed here when no copy or snapshot shares it
+     */
+    std::shared_ptr<list_storage> items;
+
+    try
+    {
+        items = std::make_shared<list_storage>();
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    items.swap(this->storage);
+    this->version += 1;
+    items.reset();
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+template<typename T>
+static void
+compact_block(std::vector<T>& data, char const *remove)
+{
+    /* Slide every run of kept values down with a single memmove */
+    std::size_t n = data.size(), dest = 0, i = 0;
+
+    while(i < n){
+        while(i < n && remove[i])
+            ++i;
+
+        std::size_t run = i;
+        while(i < n && !remove[i])
+            ++i;
+
+        if(dest != run)
+            std::memmove(data.data() + dest, data.data() + run,
+                         (i - run) * sizeof(T));
+        dest += i - run;
+    }
+
+    data.resize(dest);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::compact(std::vector<char> const& remove)
+{
+    /* Remove items whose flag is set in one pass, remove has one flag
+     * per item. Removed objects are released after the list is
+     * consistent again.
+     */
+    if(!this->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    std::vector<PyObject*> removed;
+
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        compact_block(this->storage->int_data, remove.data());
+        break;
+
+    case FLOAT64_DTYPE:
+        compact_block(this->storage->float_data, remove.data());
+        break;
+
+    default:
+    {
+        std::vector<PyObject*>& items = this->storage->container;
+
+        try
+        {
+            for(std::size_t i = 0; i < items.size(); ++i)
+                if(remove[i])
+                    removed.push_back(items[i]);
+        }
+        catch (std::bad_alloc)
+        {
+            return std::make_tuple(ERROR, PyExc_MemoryError);
+        }
+
+        compact_block(items, remove.data());
+    }
+    }
+
+    this->version += 1;
+    this->shrink_storage();
+
+    for(PyObject*& obj : removed)
+        Py_CLEAR(obj);
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::pop_tail(Py_ssize_t count, ListObject *dest)
+{
+    /* Move the last count items to the end of dest, which has the same
+     * storage type. Object references are handed over as they are.
+     */
+    if(count < 0 || count > this->getlength())
+        return std::make_tuple(ERROR, PyExc_IndexError);
+
+    if(!this->is_resizable() || !dest->is_resizable())
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    result = dest->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    Py_ssize_t first = this->getlength() - count;
+
+    try
+    {
+        switch(this->dtype)
+        {
+        case INT64_DTYPE:
+            copy_block(dest->storage->int_data,
+                       this->storage->int_data.data() + first, count);
+            this->storage->int_data.resize(first);
+            break;
+
+        case FLOAT64_DTYPE:
+            copy_block(dest->storage->float_data,
+                       this->storage->float_data.data() + first, count);
+            this->storage->float_data.resize(first);
+            break;
+
+        default:
+            copy_block(dest->storage->container,
+                       this->storage->container.data() + first, count);
+            this->storage->container.resize(first);
+        }
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    this->version += 1;
+    dest->version += 1;
+    this->shrink_storage();
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+template<typename F>
+std::tuple<int, PyObject*>
+ListObject::reorder(F f)
+{
+    /* Run f on the array of the current storage type, f only moves items
+     * so references and buffer exports stay valid
+     */
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        f(this->storage->int_data);
+        break;
+
+    case FLOAT64_DTYPE:
+        f(this->storage->float_data);
+        break;
+
+    default:
+        f(this->storage->container);
+    }
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::reverse()
+{
+    return this->reorder([](auto& data) {std::reverse(data.begin(), data.end());});
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::rotate(Py_ssize_t k)
+{
+    /* Move the last k items to the front, negative k rotates left */
+    Py_ssize_t n = this->getlength();
+    if(n < 2)
+        return std::make_tuple(SUCCESS, nullptr);
+
+    k %= n;
+    if(k < 0)
+        k += n;
+    if(k == 0)
+        return std::make_tuple(SUCCESS, nullptr);
+
+    return this->reorder([n, k](auto& data)
+                         {std::rotate(data.begin(), data.begin() + (n - k), data.end());});
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::permute(std::vector<Py_ssize_t> const& order)
+{
+    /* New item i is old item order[i], order holds one index in
+     * [0, length) per item. Nothing moves unless order is a permutation.
+     */
+    Py_ssize_t n = this->getlength();
+    if(static_cast<Py_ssize_t>(order.size()) != n)
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
+    std::vector<char> pending;
+
+    try
+    {
+        pending.assign(n, 0);
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    for(Py_ssize_t index : order){
+        if(pending[index])
+            return std::make_tuple(ERROR, PyExc_ValueError);
+        pending[index] = 1;
+    }
+
+    return this->reorder([&order, &pending, n](auto& data)
+    {
+        /* walk each cycle backwards from its leader, filling the hole */
+        for(Py_ssize_t leader = 0; leader < n; ++leader){
+            if(!pending[leader])
+                continue;
+
+            auto saved = data[leader];
+            Py_ssize_t hole = leader;
+
+            while(order[hole] != leader){
+                data[hole] = data[order[hole]];
+                pending[hole] = 0;
+                hole = order[hole];
+            }
+
+            data[hole] = saved;
+            pending[hole] = 0;
+        }
+    });
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::unshare()
+{
+    /* Copy the storage block before writing when another List or a
+     * snapshot iterator still refers to it
+     */
+    if(this->storage.use_count() == 1)
+        return std::make_tuple(SUCCESS, nullptr);
+
+    try
+    {
+        this->storage = std::make_shared<list_storage>(*this->storage);
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+ListObject::lend_storage(std::shared_ptr<list_storage>& block)
+{
+    /* Move the private storage block to block and leave the list empty,
+     * until return_storage no buffer can be exported, so the list is
+     * always resizable when the block comes back
+     */
+    std::shared_ptr<list_storage> empty;
+
+    try
+    {
+        empty = std::make_shared<list_storage>();
+    }
+    catch (std::bad_alloc)
+    {
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+    }
+
+    auto result = this->unshare();
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    block = std::move(this->storage);
+    this->storage = std::move(empty);
+    this->lent += 1;
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+bool
+ListObject::return_storage(std::shared_ptr<list_storage>& block, list_dtype dtype)
+{
+    /* Put back a block taken by lend_storage with its storage type,
+     * return false if the list was changed meanwhile (changes are dropped)
+     */
+    bool modified = this->getlength() != 0 || this->dtype != dtype;
+    assert((!modified || this->is_resizable()) && "lent List exported a buffer");
+
+    this->lent -= 1;
+    this->dtype = dtype;
+    this->storage.swap(block);
+
+    return !modified;
+}
+
+
+bool
+ListObject::accepts(PyObject *value) const
+{
+    /* Whether value can be stored without leaving the storage type */
+    return this->dtype == OBJECT_DTYPE || typed_accepts(this->dtype, value);
+}
+
+
+bool
+ListObject::is_resizable() const
+{
+    /* Exported raw arrays must not move while buffer views are alive */
+    return this->exports == 0;
+}
+
+
+template<typename T>
+static void
+grow_capacity(std::vector<T>& data, Py_ssize_t size)
+{
+    /* At least double the capacity, so repeated extends stay amortized O(1)
+     * sizes beyond max_size throw bad_alloc instead of length_error
+     */
+    Py_ssize_t capacity = data.capacity();
+    if(size <= capacity)
+        return;
+
+    Py_ssize_t max_size = data.max_size();
+    if(size > max_size)
+        throw std::bad_alloc{};
+
+    data.reserve(size > 2 * capacity ? size
+                 : capacity > max_size / 2 ? max_size : 2 * capacity);
+}
+
+
+void
+ListObject::reserve(Py_ssize_t size)
+{
+    /* Reserve storage of the current type, may throw bad_alloc
+     * an empty list gets exactly size slots
+     */
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        grow_capacity(this->storage->int_data, size);
+        break;
+    case FLOAT64_DTYPE:
+        grow_capacity(this->storage->float_data, size);
+        break;
+    default:
+        grow_capacity(this->storage->container, size);
+    }
+}
+
+
+void
+ListObject::shrink_storage()
+{
+    /* Release memory once less than half of the capacity is in use */
+    std::size_t capacity = 0;
+
+    switch(this->dtype)
+    {
+    case INT64_DTYPE:
+        capacity = this->storage->int_data.capacity();
+        break;
+    case FLOAT64_DTYPE:
+        capacity = this->storage->float_data.capacity();
+        break;
+    default:
+        capacity = this->storage->container.capacity();
+    }
+
+    if(static_cast<std::size_t>(this->getlength()) < capacity / 2){
+        this->storage->container.shrink_to_fit();
+        this->storage->int_data.shrink_to_fit();
+        this->storage->float_data.shrink_to_fit();
+    }
+}
+
+
+/* Implementation of buffer protocol */
+int
+list_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    void *data = nullptr;
+    char const *format = nullptr;
+
+    /* the items are out of the list until sort or apply_scalar returns */
+    if(_self->lent > 0){
+        view->obj = nullptr;
+        PyErr_SetString(PyExc_BufferError,
+                        "List can not export a buffer while it is being sorted or updated");
+        return -1;
+    }
+
+    /* the view is writable, so the exported block must be private */
+    if(_self->dtype != OBJECT_DTYPE){
+        int status = 0;
+        PyObject *error = nullptr;
+
+        std::tie(status, error) = _self->unshare();
+        if(status == ERROR){
+            view->obj = nullptr;
+            PyErr_SetNone(error);
+            return -1;
+        }
+    }
+
+    switch(_self->dtype)
+    {
+    case INT64_DTYPE:
+        data = _self->storage->int_data.data();
+        format = "q";
+        break;
+
+    case FLOAT64_DTYPE:
+        data = _self->storage->float_data.data();
+        format = "d";
+        break;
+
+    default:
+        view->obj = nullptr;
+        PyErr_SetString(PyExc_BufferError,
+                        "List with object storage does not export a buffer");
+        return -1;
+    }
+
+    if(_self->exports == 0)
+        _self->export_shape = _self->getlength();
+
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = data;
+    view->len = _self->export_shape * 8;
+    view->readonly = 0;
+    view->itemsize = 8;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(format) : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &_self->export_shape : nullptr;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+                        ? &view->itemsize : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+
+    _self->exports += 1;
+    return 0;
+}
+
+
+void
+list_releasebuffer(PyObject *self, Py_buffer*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+    _self->exports -= 1;
+}
+
+
+PyObject*
+list_get_dtype(PyObject *self, void*)
+{
+    ListObject *_self = static_cast<ListObject*>(self);
+
+    switch(_self->getdtype())
+    {
+    case INT64_DTYPE:
+        return PyUnicode_FromString("i8");
+    case FLOAT64_DTYPE:
+        return PyUnicode_FromString("f8");
+    default:
+        return PyUnicode_FromString("O");
+    }
+}
+
+
+/* Persistent list
+ * Items are held by PyRef values inside the nodes of an RRBVector, nodes
+ * are copied and released only while the GIL is held.
+ */
+class PyRef
+{
+public:
+    PyRef(PyObject *_obj): obj{_obj} {Py_XINCREF(this->obj);};
+    PyRef(PyRef const& other): obj{other.obj} {Py_XINCREF(this->obj);};
+    PyRef(PyRef&& other) noexcept: obj{other.obj} {other.obj = nullptr;};
+    PyRef& operator=(PyRef other) noexcept
+    {
+        std::swap(this->obj, other.obj);
+        return *this;
+    };
+    ~PyRef() {Py_XDECREF(this->obj);};
+
+    PyObject *get() const {return this->obj;};
+
+private:
+    PyObject *obj;
+};
+
+using PyRefVector = RRBVector<PyRef>;
+
+/* PersistentListType and TransientListType share their layout */
+struct PersistentListObject : public PyObject
+{
+    PersistentListObject(PyTypeObject *type, PyRefVector _items);
+
+    PyRefVector items;
+};
+
+struct PersistentListIterObject : public PyObject
+{
+    PersistentListIterObject(PyRefVector _items);
+
+    PyRefVector items;          /* snapshot, released once exhausted */
+    std::size_t currentpos;
+    PyRef const *leaf;          /* leaf holding currentpos */
+    std::size_t leaf_begin;
+    std::size_t leaf_size;
+};
+
+PyObject *plist_new(PyTypeObject *type, PyObject *args, PyObject *kwargs);
+void plist_dealloc(PyObject *self);
+Py_ssize_t plist_length(PyObject *self);
+PyObject *plist_getitem(PyObject *self, Py_ssize_t index);
+PyObject *plist_subscript(PyObject *self, PyObject *key);
+PyObject *plist_concat(PyObject *self, PyObject *other);
+PyObject *plist_set(PyObject *self, PyObject *args);
+PyObject *plist_append(PyObject *self, PyObject *value);
+PyObject *plist_extend(PyObject *self, PyObject *iterable);
+PyObject *plist_transient(PyObject *self, PyObject *unused);
+PyObject *plist_iter(PyObject *self);
+int tlist_setitem(PyObject *self, Py_ssize_t index, PyObject *value);
+PyObject *tlist_set(PyObject *self, PyObject *args);
+PyObject *tlist_append(PyObject *self, PyObject *value);
+PyObject *tlist_extend(PyObject *self, PyObject *iterable);
+PyObject *tlist_persistent(PyObject *self, PyObject *unused);
+void plistiter_dealloc(PyObject *self);
+PyObject *plist_iternext(PyObject *self);
+PyObject *plistiter_length_hint(PyObject *self, PyObject *unused);
+
+static PySequenceMethods plist_sequence = {
+    .sq_length = plist_length,
+    .sq_concat = plist_concat,
+    .sq_item = plist_getitem,
+};
+
+static PyMappingMethods plist_mapping = {
+    .mp_length = plist_length,
+    .mp_subscript = plist_subscript,
+};
+
+static PyMethodDef plist_methods[] = {
+    {"set", plist_set, METH_VARARGS, nullptr},
+    {"append", plist_append, METH_O, nullptr},
+    {"extend", plist_extend, METH_O, nullptr},
+    {"transient", plist_transient, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PySequenceMethods tlist_sequence = {
+    .sq_length = plist_length,
+    .sq_item = plist_getitem,
+    .sq_ass_item = tlist_setitem,
+};
+
+static PyMethodDef tlist_methods[] = {
+    {"set", tlist_set, METH_VARARGS, nullptr},
+    {"append", tlist_append, METH_O, nullptr},
+    {"extend", tlist_extend, METH_O, nullptr},
+    {"persistent", tlist_persistent, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyMethodDef plistiter_methods[] = {
+    {"__length_hint__", plistiter_length_hint, METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyTypeObject PersistentListType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "PersistentList",
+    .tp_basicsize = sizeof(PersistentListObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = plist_dealloc,
+    .tp_as_sequence = &plist_sequence,
+    .tp_as_mapping = &plist_mapping,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Immutable list sharing structure between versions (RRB-tree)",
+    .tp_iter = plist_iter,
+    .tp_methods = plist_methods,
+    .tp_new = plist_new,
+};
+
+static PyTypeObject TransientListType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "TransientList",
+    .tp_basicsize = sizeof(PersistentListObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = plist_dealloc,
+    .tp_as_sequence = &tlist_sequence,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Mutable builder of a PersistentList",
+    .tp_iter = plist_iter,
+    .tp_methods = tlist_methods,
+    .tp_new = nullptr,
+};
+
+static PyTypeObject PersistentListIterType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "PersistentListIter",
+    .tp_basicsize = sizeof(PersistentListIterObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = plistiter_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Iteration type of persistent list object",
+    .tp_iter = &listiter_iter,
+    .tp_iternext = &plist_iternext,
+    .tp_methods = plistiter_methods,
+    .tp_new = nullptr,
+};
+
+
+PersistentListObject::PersistentListObject(PyTypeObject *type,
+                                           PyRefVector _items)
+        : PyObject{0, type}, items{std::move(_items)}
+{/* Empty body */}
+
+
+PersistentListIterObject::PersistentListIterObject(PyRefVector _items)
+        : PyObject{0, &PersistentListIterType}, items{std::move(_items)},
+          currentpos{0}, leaf{nullptr}, leaf_begin{0}, leaf_size{0}
+{/* Empty body */}
+
+
+static PyObject*
+wrap_items(PyTypeObject *type, PyRefVector items)
+{
+    /* new PersistentList / TransientList owning items */
+    PersistentListObject *plistobj = nullptr;
+
+    try
+    {
+        plistobj = new PersistentListObject{type, std::move(items)};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(plistobj);
+    return static_cast<PyObject*>(plistobj);
+}
+
+
+static bool
+is_plist(PyObject *obj)
+{
+    return Py_TYPE(obj) == &PersistentListType
+            || Py_TYPE(obj) == &TransientListType;
+}
+
+
+static int
+extend_items(PyRefVector& items, PyObject *iterable)
+{
+    /* Append every item of iterable to items
+     * return 0 on success, -1 with exception set on failure
+     * persistent lists are concatenated without visiting their items
+     */
+    if(is_plist(iterable)){
+        try
+        {
+            items.append(static_cast<PersistentListObject*>(iterable)->items);
+        }
+        catch (std::bad_alloc)
+        {
+            PyErr_NoMemory();
+            return -1;
+        }
+        return 0;
+    }
+
+    PyObject *iterator = PyObject_GetIter(iterable);
+    if(!iterator)
+        return -1;
+
+    PyObject *item = nullptr;
+    while((item = PyIter_Next(iterator))){
+        try
+        {
+            items.push_back(PyRef{item});
+        }
+        catch (std::bad_alloc)
+        {
+            Py_DECREF(item);
+            Py_DECREF(iterator);
+            PyErr_NoMemory();
+            return -1;
+        }
+        Py_DECREF(item);
+    }
+
+    Py_DECREF(iterator);
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+
+static bool
+normalize_index(PersistentListObject *self, Py_ssize_t& index)
+{
+    /* accept negative indices, set IndexError when out of range */
+    Py_ssize_t length = self->items.size();
+    if(index < 0)
+        index += length;
+
+    if(index < 0 || index >= length){
+        PyErr_SetNone(PyExc_IndexError);
+        return false;
+    }
+
+    return true;
+}
+
+
+PyObject*
+plist_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    PyObject *iterable = nullptr;
+
+    static char const *kwlist[] = {"iterable", nullptr};
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:PersistentList",
+                                    const_cast<char**>(kwlist), &iterable))
+        return nullptr;
+
+    /* the new list owns every node, so items are appended in place */
+    PyRefVector items;
+    if(iterable && extend_items(items, iterable) < 0)
+        return nullptr;
+
+    return wrap_items(type, std::move(items));
+}
+
+
+void
+plist_dealloc(PyObject *self)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    delete _self;
+}
+
+
+Py_ssize_t
+plist_length(PyObject *self)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    return _self->items.size();
+}
+
+
+PyObject*
+plist_getitem(PyObject *self, Py_ssize_t index)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    if(index < 0 || index >= static_cast<Py_ssize_t>(_self->items.size())){
+        PyErr_SetNone(PyExc_IndexError);
+        return nullptr;
+    }
+
+    PyObject *value = _self->items[index].get();
+    Py_INCREF(value);
+    return value;
+}
+
+
+PyObject*
+plist_subscript(PyObject *self, PyObject *key)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    if(PyIndex_Check(key)){
+        Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if(index == -1 && PyErr_Occurred())
+            return nullptr;
+
+        if(!normalize_index(_self, index))
+            return nullptr;
+
+        return plist_getitem(self, index);
+    }
+
+    if(!PySlice_Check(key)){
+        PyErr_SetString(PyExc_TypeError,
+                        "PersistentList indices must be integers or slices");
+        return nullptr;
+    }
+
+    Py_ssize_t start = 0, stop = 0, step = 0;
+    if(PySlice_Unpack(key, &start, &stop, &step) < 0)
+        return nullptr;
+
+    Py_ssize_t length = PySlice_AdjustIndices(_self->items.size(),
+                                              &start, &stop, step);
+    PyRefVector items;
+
+    try
+    {
+        /* contiguous slices share nodes with self */
+        if(step == 1)
+            items = _self->items.slice(start, stop);
+        else
+            for(Py_ssize_t i = 0; i < length; ++i)
+                items.push_back(_self->items[start + i * step]);
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    return wrap_items(&PersistentListType, std::move(items));
+}
+
+
+PyObject*
+plist_concat(PyObject *self, PyObject *other)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    if(!is_plist(other)){
+        PyErr_Format(PyExc_TypeError,
+                     "can only concatenate PersistentList (not \"%.200s\")",
+                     Py_TYPE(other)->tp_name);
+        return nullptr;
+    }
+
+    PyRefVector items{_self->items};
+    if(extend_items(items, other) < 0)
+        return nullptr;
+
+    return wrap_items(&PersistentListType, std::move(items));
+}
+
+
+static bool
+parse_set_args(PersistentListObject *self, PyObject *args,
+               Py_ssize_t& index, PyObject *&value)
+{
+    if(!PyArg_ParseTuple(args, "nO:set", &index, &value))
+        return false;
+
+    return normalize_index(self, index);
+}
+
+
+PyObject*
+plist_set(PyObject *self, PyObject *args)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    Py_ssize_t index = 0;
+    PyObject *value = nullptr;
+    if(!parse_set_args(_self, args, index, value))
+        return nullptr;
+
+    /* path from root to the leaf is copied, everything else is shared */
+    PyRefVector items{_self->items};
+
+    try
+    {
+        items.set(index, PyRef{value});
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    return wrap_items(&PersistentListType, std::move(items));
+}
+
+
+PyObject*
+plist_append(PyObject *self, PyObject *value)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    PyRefVector items{_self->items};
+
+    try
+    {
+        items.push_back(PyRef{value});
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    return wrap_items(&PersistentListType, std::move(items));
+}
+
+
+PyObject*
+plist_extend(PyObject *self, PyObject *iterable)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    /* only the first append copies shared nodes, later ones reuse them */
+    PyRefVector items{_self->items};
+    if(extend_items(items, iterable) < 0)
+        return nullptr;
+
+    return wrap_items(&PersistentListType, std::move(items));
+}
+
+
+PyObject*
+plist_transient(PyObject *self, PyObject*)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    return wrap_items(&TransientListType, _self->items);
+}
+
+
+int
+tlist_setitem(PyObject *self, Py_ssize_t index, PyObject *value)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    if(!value){
+        PyErr_SetString(PyExc_TypeError,
+                        "TransientList does not support deletion");
+        return -1;
+    }
+
+    if(index < 0 || index >= static_cast<Py_ssize_t>(_self->items.size())){
+        PyErr_SetNone(PyExc_IndexError);
+        return -1;
+    }
+
+    try
+    {
+        _self->items.set(index, PyRef{value});
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    return 0;
+}
+
+
+PyObject*
+tlist_set(PyObject *self, PyObject *args)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    Py_ssize_t index = 0;
+    PyObject *value = nullptr;
+    if(!parse_set_args(_self, args, index, value))
+        return nullptr;
+
+    if(tlist_setitem(self, index, value) < 0)
+        return nullptr;
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+tlist_append(PyObject *self, PyObject *value)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    try
+    {
+        _self->items.push_back(PyRef{value});
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+tlist_extend(PyObject *self, PyObject *iterable)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+
+    if(extend_items(_self->items, iterable) < 0)
+        return nullptr;
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+tlist_persistent(PyObject *self, PyObject*)
+{
+    /* the snapshot shares every node, later updates of the transient
+     * copy the nodes they touch
+     */
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    return wrap_items(&PersistentListType, _self->items);
+}
+
+
+PyObject*
+plist_iter(PyObject *self)
+{
+    PersistentListObject *_self = static_cast<PersistentListObject*>(self);
+    PersistentListIterObject *iterobj = nullptr;
+
+    try
+    {
+        iterobj = new PersistentListIterObject{_self->items};
+    }
+    catch (std::bad_alloc)
+    {
+        PyErr_NoMemory();
+        return nullptr;
+    }
+
+    Py_INCREF(iterobj);
+    return static_cast<PyObject*>(iterobj);
+}
+
+
+void
+plistiter_dealloc(PyObject *self)
+{
+    PersistentListIterObject *_self = static_cast<PersistentListIterObject*>(self);
+    delete _self;
+}
+
+
+PyObject*
+plist_iternext(PyObject *self)
+{
+    PersistentListIterObject *_self = static_cast<PersistentListIterObject*>(self);
+    std::size_t pos = _self->currentpos;
+
+    if(pos >= _self->items.size()){
+        _self->leaf = nullptr;
+        _self->items.clear();
+        return nullptr;
+    }
+
+    /* walk down the tree once per leaf */
+    if(!_self->leaf || pos - _self->leaf_begin >= _self->leaf_size)
+        _self->leaf = _self->items.leaf_for(pos, _self->leaf_begin,
+                                            _self->leaf_size);
+
+    PyObject *value = _self->leaf[pos - _self->leaf_begin].get();
+    _self->currentpos = pos + 1;
+    Py_INCREF(value);
+    return value;
+}
+
+
+PyObject*
+plistiter_length_hint(PyObject *self, PyObject*)
+{
+    PersistentListIterObject *_self = static_cast<PersistentListIterObject*>(self);
+    std::size_t size = _self->items.size();
+    std::size_t pos = _self->currentpos;
+
+    return PyLong_FromSize_t(pos < size ? size - pos : 0);
+}
+
+
+/* Memory-mapped list
+ * MappedList(path, dtype) keeps int64 / float64 values in a file mapped
+ * with mmap (POSIX only). The file starts with a 16 byte header, a magic
+ * naming the dtype and the current length, followed by the raw values,
+ * so a reader can map it at offset 16. Appends grow the file
+ * geometrically and map it again, values are boxed only on access.
+ */
+struct mapped_header
+{
+    char magic[8];              /* "LSTMAPi8" or "LSTMAPf8" */
+    std::int64_t length;
+};
+
+class MappedListObject : public PyObject
+{
+public: /* Public interfaces */
+    MappedListObject();
+    ~MappedListObject();
+
+    std::tuple<int, PyObject*> open(char const *path, list_dtype _dtype);
+    std::tuple<int, PyObject*> close();
+    std::tuple<int, PyObject*> flush();
+    std::tuple<int, PyObject*> advise(int _advice);
+    /* typed sequence interface, the mapping must be open */
+    bool is_open() const {return this->header != nullptr;};
+    Py_ssize_t getlength() const {return this->header->length;};
+    list_dtype getdtype() const {return this->dtype;};
+    void const *typed_data() const {return this->data();};
+    inline PyObject *item(Py_ssize_t index) const;
+    std::tuple<int, PyObject*> getter(Py_ssize_t index) const;
+    std::tuple<int, PyObject*> setter(Py_ssize_t index, PyObject *value);
+    std::tuple<int, PyObject*> deleter(Py_ssize_t index);
+    std::tuple<int, PyObject*> appender(PyObject *value);
+
+    friend int mappedlist_getbuffer(PyObject *self, Py_buffer *view, int flags);
+    friend void mappedlist_releasebuffer(PyObject *self, Py_buffer *view);
+
+private: /* helper methods */
+    std::uint64_t *data() const
+    {
+        return reinterpret_cast<std::uint64_t*>(this->header + 1);
+    };
+    std::tuple<int, PyObject*> to_bits(PyObject *value, std::uint64_t& bits) const;
+    std::tuple<int, PyObject*> remap(Py_ssize_t new_capacity);
+
+private: /* Data members */
+    int fd;
+    list_dtype dtype;
+    mapped_header *header;      /* start of the mapping, nullptr if closed */
+    std::size_t mapped_size;
+    Py_ssize_t capacity;        /* values the file has room for */
+    int advice;                 /* madvise hint, kept across remaps */
+    Py_ssize_t exports;
+    Py_ssize_t export_shape;
+};
+
+PyObject *mappedlist_new(PyTypeObject *type, PyObject *args, PyObject *kwargs);
+void mappedlist_dealloc(PyObject *self);
+int mappedlist_contains(PyObject *self, PyObject *value);
+PyObject *mappedlist_extend(PyObject *self, PyObject *iterable);
+PyObject *mappedlist_flush(PyObject *self, PyObject *unused);
+PyObject *mappedlist_close(PyObject *self, PyObject *unused);
+PyObject *mappedlist_advise(PyObject *self, PyObject *args);
+PyObject *mappedlist_get_dtype(PyObject *self, void *closure);
+int mappedlist_getbuffer(PyObject *self, Py_buffer *view, int flags);
+void mappedlist_releasebuffer(PyObject *self, Py_buffer *view);
+
+static PySequenceMethods mappedlist_sequence = {
+    .sq_length = seq_length<MappedListObject>,
+    .sq_item = seq_getitem<MappedListObject>,
+    .sq_ass_item = seq_setitem<MappedListObject>,
+    .sq_contains = mappedlist_contains,
+};
+
+static PyBufferProcs mappedlist_buffer = {
+    .bf_getbuffer = mappedlist_getbuffer,
+    .bf_releasebuffer = mappedlist_releasebuffer,
+};
+
+static PyMethodDef mappedlist_methods[] = {
+    {"append", seq_append<MappedListObject>, METH_O, nullptr},
+    {"extend", mappedlist_extend, METH_O, nullptr},
+    {"flush", mappedlist_flush, METH_NOARGS, nullptr},
+    {"close", mappedlist_close, METH_NOARGS, nullptr},
+    {"advise", mappedlist_advise, METH_VARARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyGetSetDef mappedlist_getset[] = {
+    {"dtype", mappedlist_get_dtype, nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyTypeObject MappedListType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "list.MappedList",
+    .tp_basicsize = sizeof(MappedListObject),
+    .tp_itemsize = 0,
+    .tp_dealloc = mappedlist_dealloc,
+    .tp_as_sequence = &mappedlist_sequence,
+    .tp_as_buffer = &mappedlist_buffer,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "List of int64 / float64 values stored in a memory-mapped file",
+    .tp_iter = PySeqIter_New,
+    .tp_methods = mappedlist_methods,
+    .tp_getset = mappedlist_getset,
+    .tp_new = mappedlist_new,
+};
+
+
+MappedListObject::MappedListObject()
+        : PyObject{0, &MappedListType}, fd{-1}, dtype{INT64_DTYPE},
+          header{nullptr}, mapped_size{0}, capacity{0},
+          advice{MADV_NORMAL}, exports{0}, export_shape{0}
+{/* Empty body */}
+
+
+MappedListObject::~MappedListObject()
+{
+    assert(this->exports == 0 && "MappedListObject has live buffer views");
+    this->close();
+}
+
+
+PyObject*
+MappedListObject::item(Py_ssize_t index) const
+{
+    /* new reference to the value at a valid index */
+    if(this->dtype == INT64_DTYPE){
+        std::int64_t value;
+        std::memcpy(&value, this->data() + index, sizeof(value));
+        return box_value(value);
+    }
+
+    double value;
+    std::memcpy(&value, this->data() + index, sizeof(value));
+    return box_value(value);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::open(char const *path, list_dtype _dtype)
+{
+    /* Map an existing file of the same dtype, or create an empty one
+     * OSError leaves errno set for the caller
+     */
+    char const *magic = _dtype == INT64_DTYPE ? "LSTMAPi8" : "LSTMAPf8";
+    this->dtype = _dtype;
+
+    this->fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if(this->fd < 0)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    struct stat info;
+    if(fstat(this->fd, &info) < 0)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    if(info.st_size == 0){
+        /* first page holds the header and the first values */
+        Py_ssize_t first = (4096 - sizeof(mapped_header)) / 8;
+        auto result = this->remap(first);
+        if(std::get<0>(result) == ERROR)
+            return result;
+
+        std::memcpy(this->header->magic, magic, 8);
+        this->header->length = 0;
+        return std::make_tuple(SUCCESS, nullptr);
+    }
+
+    if(info.st_size < static_cast<off_t>(sizeof(mapped_header)))
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
+    auto result = this->remap((info.st_size - sizeof(mapped_header)) / 8);
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    if(std::memcmp(this->header->magic, magic, 8) != 0
+            || this->header->length < 0
+            || this->header->length > this->capacity)
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::remap(Py_ssize_t new_capacity)
+{
+    /* Resize the file to hold new_capacity values and map all of it */
+    std::size_t size = sizeof(mapped_header) + new_capacity * 8;
+
+    if(static_cast<std::size_t>(lseek(this->fd, 0, SEEK_END)) < size
+            && ftruncate(this->fd, size) < 0)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         this->fd, 0);
+    if(mapping == MAP_FAILED)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    if(this->header)
+        munmap(this->header, this->mapped_size);
+
+    this->header = static_cast<mapped_header*>(mapping);
+    this->mapped_size = size;
+    this->capacity = new_capacity;
+
+    if(this->advice != MADV_NORMAL)
+        madvise(mapping, size, this->advice);
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::close()
+{
+    /* Unmap and close, the file keeps the values and the length */
+    if(this->exports > 0)
+        return std::make_tuple(ERROR, PyExc_BufferError);
+
+    if(this->header){
+        munmap(this->header, this->mapped_size);
+        this->header = nullptr;
+        this->mapped_size = 0;
+        this->capacity = 0;
+    }
+
+    if(this->fd >= 0){
+        ::close(this->fd);
+        this->fd = -1;
+    }
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::flush()
+{
+    /* Write dirty pages back to the file synchronously */
+    if(msync(this->header, this->mapped_size, MS_SYNC) < 0)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::advise(int _advice)
+{
+    if(madvise(this->header, this->mapped_size, _advice) < 0)
+        return std::make_tuple(ERROR, PyExc_OSError);
+
+    /* WILLNEED / DONTNEED act once, the others describe the access pattern */
+    if(_advice != MADV_WILLNEED && _advice != MADV_DONTNEED)
+        this->advice = _advice;
+
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::to_bits(PyObject *value, std::uint64_t& bits) const
+{
+    /* Raw value of value for the storage type. There is no object storage
+     * to fall back to, so values typed_accepts refuses are converted:
+     * int subclasses for 'i8', anything with __float__ for 'f8'
+     */
+    if(this->dtype == INT64_DTYPE){
+        if(!PyLong_Check(value)){
+            PyErr_Format(PyExc_TypeError, "MappedList of 'i8' needs int, not %.200s",
+                         Py_TYPE(value)->tp_name);
+            return std::make_tuple(ERROR, PyExc_TypeError);
+        }
+
+        std::int64_t raw = PyLong_AsLongLong(value);
+        if(raw == -1 && PyErr_Occurred())
+            return std::make_tuple(ERROR, PyExc_OverflowError);
+
+        std::memcpy(&bits, &raw, sizeof(bits));
+        return std::make_tuple(SUCCESS, nullptr);
+    }
+
+    /* anything with __float__ */
+    double raw = PyFloat_AsDouble(value);
+    if(raw == -1.0 && PyErr_Occurred())
+        return std::make_tuple(ERROR, PyExc_TypeError);
+
+    std::memcpy(&bits, &raw, sizeof(bits));
+    return std::make_tuple(SUCCESS, nullptr);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::getter(Py_ssize_t index) const
+{
+    if(!this->is_open())
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
     if(index < 0 || index >= this->getlength())
         return std::make_tuple(ERROR, PyExc_IndexError);
 
-    /* Change existing values stored at index */
-    Py_CLEAR(this->container[index]);
-    this->container[index] = value;
-    return std::make_tuple(SUCCESS, nullptr);
+    PyObject *value = this->item(index);
+    if(!value)
+        return std::make_tuple(ERROR, PyExc_MemoryError);
+
+    return std::make_tuple(SUCCESS, value);
 }
 
 
 std::tuple<int, PyObject*>
-ListObject::deleter(Py_ssize_t index)
+MappedListObject::setter(Py_ssize_t index, PyObject *value)
 {
-    /* Check validity of index */
+    if(!this->is_open())
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
     if(index < 0 || index >= this->getlength())
         return std::make_tuple(ERROR, PyExc_IndexError);
 
-    /* Delete item */
-    Py_CLEAR(this->container[index]);
-    
-    /* Shift list items after the deleted item */
-    Py_ssize_t item_num = this->container.size();
+    std::uint64_t bits = 0;
+    auto result = this->to_bits(value, bits);
+    if(std::get<0>(result) == ERROR)
+        return result;
 
-    for(Py_ssize_t i = index + 1; i < item_num; ++i)
-        this->container[i - 1] = this->container[i];
+    this->data()[index] = bits;
+    return std::make_tuple(SUCCESS, nullptr);
+}
 
-    this->container[item_num] = nullptr;
-    
-    /* Remove the last item */
-    this->container.pop_back();
 
-    /* Resize container if actual actual storage < 1/2 of capacity */
-    --item_num;
-    Py_ssize_t capacity = this->container.capacity(); 
+std::tuple<int, PyObject*>
+MappedListObject::deleter(Py_ssize_t)
+{
+    /* the file only grows at the end */
+    PyErr_SetString(PyExc_TypeError, "MappedList does not support deletion");
+    return std::make_tuple(ERROR, PyExc_TypeError);
+}
+
+
+std::tuple<int, PyObject*>
+MappedListObject::appender(PyObject *value)
+{
+    if(!this->is_open())
+        return std::make_tuple(ERROR, PyExc_ValueError);
+
+    std::uint64_t bits = 0;
+    auto result = this->to_bits(value, bits);
+    if(std::get<0>(result) == ERROR)
+        return result;
+
+    Py_ssize_t length = this->getlength();
 
-    if(item_num < capacity / 2) 
-        this->container.shrink_to_fit();
+    if(length == this->capacity){
+        /* the mapping moves, so exported views must be gone */
+        if(this->exports > 0)
+            return std::make_tuple(ERROR, PyExc_BufferError);
 
+        Py_ssize_t first = (4096 - sizeof(mapped_header)) / 8;
+        result = this->remap(this->capacity < first ? first : 2 * this->capacity);
+        if(std::get<0>(result) == ERROR)
+            return result;
+    }
+
+    this->data()[length] = bits;
+    this->header->length = length + 1;
     return std::make_tuple(SUCCESS, nullptr);
 }
 
 
+PyObject*
+mappedlist_new(PyTypeObject*, PyObject *args, PyObject *kwargs)
+{
+    PyObject *path = nullptr;
+    char const *dtype = nullptr;
+
+    static char const *kwlist[] = {"path", "dtype", nullptr};
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "O&s:MappedList",
+                                    const_cast<char**>(kwlist),
+                                    PyUnicode_FSConverter, &path, &dtype))
+        return nullptr;
+
+    list_dtype new_dtype = OBJECT_DTYPE;
+    if(!parse_dtype(dtype, new_dtype) || new_dtype == OBJECT_DTYPE){
+        if(!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError,
+                            "MappedList requires dtype 'i8' or 'f8'");
+        Py_DECREF(path);
+        return nullptr;
+    }
+
+    MappedListObject *mappedobj = nullptr;
+
+    try
+    {
+        mappedobj = new MappedListObject{};
+    }
+    catch (std::bad_alloc)
+    {
+        Py_DECREF(path);
+        PyErr_NoMemory();
+        return nullptr;
+    }
+    Py_INCREF(mappedobj);
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = mappedobj->open(PyBytes_AS_STRING(path), new_dtype);
+    if(status == ERROR){
+        if(error == PyExc_ValueError)
+            PyErr_Format(PyExc_ValueError,
+                         "%s is not a MappedList file of dtype '%s'",
+                         PyBytes_AS_STRING(path), dtype);
+        else
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError,
+                                           PyBytes_AS_STRING(path));
+        Py_DECREF(path);
+        Py_DECREF(mappedobj);
+        return nullptr;
+    }
+
+    Py_DECREF(path);
+    return static_cast<PyObject*>(mappedobj);
+}
+
+
+void
+mappedlist_dealloc(PyObject *self)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+    delete _self;
+}
+
+
+int
+mappedlist_contains(PyObject *self, PyObject *value)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+
+    if(!check_open(_self))
+        return -1;
+
+    Py_ssize_t pos = typed_find(_self, value, 0, _self->getlength());
+    if(pos == -2)
+        return -1;
+
+    return pos >= 0;
+}
+
+
+PyObject*
+mappedlist_extend(PyObject *self, PyObject *iterable)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+
+    if(!check_open(_self))
+        return nullptr;
+
+    PyObject *iter = PyObject_GetIter(iterable);
+    if(!iter)
+        return nullptr;
+
+    PyObject *item = nullptr;
+    while((item = PyIter_Next(iter))){
+        int status = 0;
+        PyObject *error = nullptr;
+
+        /* appender fails once the iterable closes the list meanwhile */
+        std::tie(status, error) = _self->appender(item);
+        Py_DECREF(item);
+
+        if(status == ERROR){
+            Py_DECREF(iter);
+            if(!_self->is_open())
+                check_open(_self);
+            else
+                set_status_error(error);
+            return nullptr;
+        }
+    }
+
+    Py_DECREF(iter);
+    if(PyErr_Occurred())
+        return nullptr;
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+mappedlist_flush(PyObject *self, PyObject*)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+
+    if(!check_open(_self))
+        return nullptr;
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->flush();
+    if(status == ERROR){
+        set_status_error(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+mappedlist_close(PyObject *self, PyObject*)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->close();
+    if(status == ERROR){
+        set_status_error(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+mappedlist_advise(PyObject *self, PyObject *args)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+    char const *name = nullptr;
+
+    if(!PyArg_ParseTuple(args, "s:advise", &name))
+        return nullptr;
+
+    if(!check_open(_self))
+        return nullptr;
+
+    int advice = 0;
+    if(std::strcmp(name, "normal") == 0)
+        advice = MADV_NORMAL;
+    else if(std::strcmp(name, "sequential") == 0)
+        advice = MADV_SEQUENTIAL;
+    else if(std::strcmp(name, "random") == 0)
+        advice = MADV_RANDOM;
+    else if(std::strcmp(name, "willneed") == 0)
+        advice = MADV_WILLNEED;
+    else if(std::strcmp(name, "dontneed") == 0)
+        advice = MADV_DONTNEED;
+    else {
+        PyErr_Format(PyExc_ValueError,
+                     "advice must be 'normal', 'sequential', 'random', "
+                     "'willneed' or 'dontneed', not '%s'", name);
+        return nullptr;
+    }
+
+    int status = 0;
+    PyObject *error = nullptr;
+
+    std::tie(status, error) = _self->advise(advice);
+    if(status == ERROR){
+        set_status_error(error);
+        return nullptr;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+PyObject*
+mappedlist_get_dtype(PyObject *self, void*)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+    return PyUnicode_FromString(_self->getdtype() == INT64_DTYPE ? "i8" : "f8");
+}
+
+
+int
+mappedlist_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+
+    if(!check_open(_self)){
+        view->obj = nullptr;
+        return -1;
+    }
+
+    if(_self->exports == 0)
+        _self->export_shape = _self->getlength();
+
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = _self->data();
+    view->len = _self->export_shape * 8;
+    view->readonly = 0;
+    view->itemsize = 8;
+    view->format = (flags & PyBUF_FORMAT)
+                        ? const_cast<char*>(_self->dtype == INT64_DTYPE ? "q" : "d")
+                        : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &_self->export_shape : nullptr;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+                        ? &view->itemsize : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+
+    _self->exports += 1;
+    return 0;
+}
+
+
+void
+mappedlist_releasebuffer(PyObject *self, Py_buffer*)
+{
+    MappedListObject *_self = static_cast<MappedListObject*>(self);
+    _self->exports -= 1;
+}
+
+
 static PyModuleDef list_module = {
-    PyModuleDef_HEAD_INIT,
+    .m_base = PyModuleDef_HEAD_INIT,
     .m_name = "list",
     .m_doc = "List object reimplemented in C++",
     .m_size = -1,
@@ -363,6 +5200,30 @@ PyInit_list(void)
         return nullptr;
     }
 
+    if(PyType_Ready(&ListIterType) < 0 || PyType_Ready(&ListRevIterType) < 0
+       || PyType_Ready(&ListSnapshotIterType) < 0){
+        PyErr_SetString(PyExc_RuntimeError, "Can not initialize ListIterType");
+        return nullptr;
+    }
+
+    if(PyType_Ready(&ListViewType) < 0){
+        PyErr_SetString(PyExc_RuntimeError, "Can not initialize ListViewType");
+        return nullptr;
+    }
+
+    if(PyType_Ready(&PersistentListType) < 0
+       || PyType_Ready(&TransientListType) < 0
+       || PyType_Ready(&PersistentListIterType) < 0){
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Can not initialize PersistentListType");
+        return nullptr;
+    }
+
+    if(PyType_Ready(&MappedListType) < 0){
+        PyErr_SetString(PyExc_RuntimeError, "Can not initialize MappedListType");
+        return nullptr;
+    }
+
     PyObject *module = PyModule_Create(&list_module);
     if(!module){
         PyErr_SetString(PyExc_RuntimeError, "Can not initialize list module");
@@ -376,5 +5237,24 @@ PyInit_list(void)
         return nullptr;
     }
 
+    Py_INCREF(&PersistentListType);
+    Py_INCREF(&TransientListType);
+    if(PyModule_AddObject(module, "PersistentList",
+                          (PyObject*) &PersistentListType) < 0
+       || PyModule_AddObject(module, "TransientList",
+                             (PyObject*) &TransientListType) < 0){
+        Py_DECREF(module);
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Can not add PersistentListType to module");
+        return nullptr;
+    }
+
+    Py_INCREF(&MappedListType);
+    if(PyModule_AddObject(module, "MappedList", (PyObject*) &MappedListType) < 0){
+        Py_DECREF(module);
+        PyErr_SetString(PyExc_RuntimeError, "Can not add MappedListType to module");
+        return nullptr;
+    }
+
     return module;        
 }
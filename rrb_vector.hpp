@@ -0,0 +1,535 @@
+#ifndef RRB_VECTOR_H
+#define RRB_VECTOR_H
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+//Persistent vector based on a relaxed radix balanced tree (RRB-tree)
+//  - leaves hold up to 32 values, internal nodes up to 32 children
+//  - internal nodes keep cumulative sizes of their children, so subtrees
+//    may be partially filled (relaxed) after concatenation and slicing
+//  - copies share the whole tree in O(1)
+//  - mutating members copy only the nodes on the modified path which are
+//    shared with another vector, nodes owned by this vector alone are
+//    changed in place. A vector which is not copied therefore behaves as
+//    a transient (batch mutable) builder, and persistent updates are
+//    "copy, then mutate the copy"
+//
+//Node ownership relies on shared_ptr::use_count, so a tree must not be
+//copied and mutated from different threads at the same time.
+
+template<typename T>
+class RRBVector
+{
+public:
+    static constexpr std::size_t BITS = 5;
+    static constexpr std::size_t BRANCH = std::size_t{1} << BITS;
+
+    //ctors, assignments, dtor
+    RRBVector(): root{}, height{0}, count{0} {};
+    RRBVector(RRBVector const&) = default;
+    RRBVector& operator=(RRBVector const&) = default;
+    RRBVector(RRBVector&&) = default;
+    RRBVector& operator=(RRBVector&&) = default;
+    ~RRBVector() = default;
+
+    //observers
+    std::size_t size() const {return count;};
+    bool empty() const {return count == 0;};
+    T const& operator[](std::size_t index) const;
+    T const* leaf_for(std::size_t index, std::size_t& leaf_begin,
+                      std::size_t& leaf_size) const;
+
+    //operations, O(log32 n) unless stated otherwise
+    void set(std::size_t index, T value);
+    void push_back(T value);
+    void append(RRBVector const& other);
+    void take(std::size_t n);   //keep first n values
+    void drop(std::size_t n);   //remove first n values
+    RRBVector slice(std::size_t begin, std::size_t end) const;
+    void clear();
+
+private:
+    //member types
+    struct node;
+    using node_ptr = std::shared_ptr<node>;
+    using node_list = std::vector<node_ptr>;
+
+    //helpers
+    static void make_unique(node_ptr& p);
+    static std::size_t total(node const& n, std::size_t h);
+    static std::size_t slots(node const& n, std::size_t h);
+    static std::size_t child_index(node const& n, std::size_t h, std::size_t index);
+    static void update_sizes(node& n, std::size_t h);
+    static node_ptr new_path(std::size_t h, T value);
+    static bool push_rec(node& n, std::size_t h, T& value);
+    static node_list concat_nodes(node_ptr const& left, std::size_t hl,
+                                  node_ptr const& right, std::size_t hr);
+    static node_list rebalance(node_list const& nodes, std::size_t h);
+    static node_list pack(node_list const& children, std::size_t h);
+    static node_ptr take_node(node_ptr const& n, std::size_t h, std::size_t keep);
+    static node_ptr drop_node(node_ptr const& n, std::size_t h, std::size_t skip);
+    void collapse_root();
+
+    //member data
+    node_ptr root;
+    std::size_t height;     //0 when root is a leaf
+    std::size_t count;
+};
+
+template<typename T>
+struct RRBVector<T>::node
+{
+    std::vector<T> items;               //leaf only
+    node_list children;                 //internal only
+    std::vector<std::size_t> sizes;     //cumulative sizes of children
+};
+
+template<typename T>
+void RRBVector<T>::make_unique(node_ptr& p)
+{
+    //copy a node shared with another tree, children stay shared
+    if(p.use_count() != 1)
+        p = std::make_shared<node>(*p);
+}
+
+template<typename T>
+std::size_t RRBVector<T>::total(node const& n, std::size_t h)
+{
+    return h == 0 ? n.items.size() : n.sizes.back();
+}
+
+template<typename T>
+std::size_t RRBVector<T>::slots(node const& n, std::size_t h)
+{
+    return h == 0 ? n.items.size() : n.children.size();
+}
+
+template<typename T>
+std::size_t RRBVector<T>::child_index(node const& n, std::size_t h,
+                                      std::size_t index)
+{
+    //radix guess is exact for dense subtrees and never too far right
+    std::size_t idx = index >> (BITS * h);
+    if(idx >= n.children.size())
+        idx = n.children.size() - 1;
+
+    while(n.sizes[idx] <= index)
+        ++idx;
+
+    return idx;
+}
+
+template<typename T>
+void RRBVector<T>::update_sizes(node& n, std::size_t h)
+{
+    std::size_t sum = 0;
+    n.sizes.resize(n.children.size());
+
+    for(std::size_t i = 0; i < n.children.size(); ++i){
+        sum += total(*n.children[i], h - 1);
+        n.sizes[i] = sum;
+    }
+}
+
+template<typename T>
+typename RRBVector<T>::node_ptr RRBVector<T>::new_path(std::size_t h, T value)
+{
+    node_ptr leaf = std::make_shared<node>();
+    leaf->items.push_back(std::move(value));
+
+    for(std::size_t level = 1; level <= h; ++level){
+        node_ptr parent = std::make_shared<node>();
+        parent->children.push_back(std::move(leaf));
+        parent->sizes.push_back(1);
+        leaf = std::move(parent);
+    }
+
+    return leaf;
+}
+
+template<typename T>
+T const& RRBVector<T>::operator[](std::size_t index) const
+{
+    assert(index < count && "RRBVector index out of range");
+
+    node const* n = root.get();
+    for(std::size_t h = height; h > 0; --h){
+        std::size_t idx = child_index(*n, h, index);
+        if(idx > 0)
+            index -= n->sizes[idx - 1];
+        n = n->children[idx].get();
+    }
+
+    return n->items[index];
+}
+
+template<typename T>
+T const* RRBVector<T>::leaf_for(std::size_t index, std::size_t& leaf_begin,
+                                std::size_t& leaf_size) const
+{
+    //values of the leaf holding index, for iteration leaf by leaf
+    assert(index < count && "RRBVector index out of range");
+
+    node const* n = root.get();
+    leaf_begin = index;
+
+    for(std::size_t h = height; h > 0; --h){
+        std::size_t idx = child_index(*n, h, index);
+        if(idx > 0)
+            index -= n->sizes[idx - 1];
+        n = n->children[idx].get();
+    }
+
+    leaf_begin -= index;
+    leaf_size = n->items.size();
+    return n->items.data();
+}
+
+template<typename T>
+void RRBVector<T>::set(std::size_t index, T value)
+{
+    assert(index < count && "RRBVector index out of range");
+
+    make_unique(root);
+    node* n = root.get();
+
+    for(std::size_t h = height; h > 0; --h){
+        std::size_t idx = child_index(*n, h, index);
+        if(idx > 0)
+            index -= n->sizes[idx - 1];
+
+        make_unique(n->children[idx]);
+        n = n->children[idx].get();
+    }
+
+    n->items[index] = std::move(value);
+}
+
+template<typename T>
+bool RRBVector<T>::push_rec(node& n, std::size_t h, T& value)
+{
+    //n is owned by this tree, return false if the subtree is full
+    if(h == 0){
+        if(n.items.size() == BRANCH)
+            return false;
+
+        n.items.push_back(std::move(value));
+        return true;
+    }
+
+    make_unique(n.children.back());
+    if(push_rec(*n.children.back(), h - 1, value)){
+        n.sizes.back() += 1;
+        return true;
+    }
+
+    if(n.children.size() == BRANCH)
+        return false;
+
+    n.children.push_back(new_path(h - 1, std::move(value)));
+    n.sizes.push_back(n.sizes.back() + 1);
+    return true;
+}
+
+template<typename T>
+void RRBVector<T>::push_back(T value)
+{
+    if(!root){
+        root = new_path(0, std::move(value));
+        height = 0;
+        count = 1;
+        return;
+    }
+
+    make_unique(root);
+    if(!push_rec(*root, height, value)){
+        //tree is full, grow a new root
+        node_ptr new_root = std::make_shared<node>();
+        new_root->children.push_back(std::move(root));
+        new_root->children.push_back(new_path(height, std::move(value)));
+        new_root->sizes = {count, count + 1};
+        root = std::move(new_root);
+        ++height;
+    }
+
+    ++count;
+}
+
+template<typename T>
+typename RRBVector<T>::node_list
+RRBVector<T>::pack(node_list const& children, std::size_t h)
+{
+    //group nodes of height h - 1 under parents of height h
+    node_list parents;
+
+    for(std::size_t i = 0; i < children.size(); i += BRANCH){
+        node_ptr parent = std::make_shared<node>();
+        std::size_t end = i + BRANCH < children.size() ? i + BRANCH
+                                                        : children.size();
+        parent->children.assign(children.begin() + i, children.begin() + end);
+        update_sizes(*parent, h);
+        parents.push_back(std::move(parent));
+    }
+
+    return parents;
+}
+
+template<typename T>
+typename RRBVector<T>::node_list
+RRBVector<T>::rebalance(node_list const& nodes, std::size_t h)
+{
+    //Concatenation plan of Bagwell & Rompf: nodes of height h are merged
+    //until their number is at most optimal + EXTRAS, nodes with at most
+    //BRANCH - INVARIANT slots are spread over their right neighbours
+    constexpr std::size_t EXTRAS = 2;
+    constexpr std::size_t INVARIANT = 1;
+
+    std::vector<std::size_t> plan;
+    std::size_t total_slots = 0;
+    for(node_ptr const& n : nodes){
+        plan.push_back(slots(*n, h));
+        total_slots += plan.back();
+    }
+
+    std::size_t optimal = (total_slots + BRANCH - 1) / BRANCH;
+    std::size_t len = plan.size();
+    if(len <= optimal + EXTRAS)
+        return nodes;
+
+    std::size_t i = 0;
+    while(optimal + EXTRAS < len){
+        while(plan[i] > BRANCH - INVARIANT)
+            ++i;
+
+        std::size_t remaining = plan[i];
+        do
+        {
+            std::size_t merged = remaining + plan[i + 1];
+            std::size_t fill = merged < BRANCH ? merged : BRANCH;
+            plan[i] = fill;
+            remaining = merged - fill;
+            ++i;
+        }
+        while(remaining > 0);
+
+        for(std::size_t j = i; j + 1 < len; ++j)
+            plan[j] = plan[j + 1];
+        --len;
+        --i;
+    }
+    plan.resize(len);
+
+    //execute the plan, reusing nodes which keep their exact content
+    node_list result;
+    std::size_t src = 0, offset = 0;
+
+    for(std::size_t wanted : plan){
+        if(offset == 0 && slots(*nodes[src], h) == wanted){
+            result.push_back(nodes[src++]);
+            continue;
+        }
+
+        node_ptr fresh = std::make_shared<node>();
+        std::size_t filled = 0;
+
+        while(filled < wanted){
+            node const& from = *nodes[src];
+            std::size_t available = slots(from, h) - offset;
+            std::size_t step = wanted - filled < available ? wanted - filled
+                                                           : available;
+            if(h == 0)
+                fresh->items.insert(fresh->items.end(),
+                                    from.items.begin() + offset,
+                                    from.items.begin() + offset + step);
+            else
+                fresh->children.insert(fresh->children.end(),
+                                       from.children.begin() + offset,
+                                       from.children.begin() + offset + step);
+
+            filled += step;
+            offset += step;
+            if(offset == slots(from, h)){
+                ++src;
+                offset = 0;
+            }
+        }
+
+        if(h > 0)
+            update_sizes(*fresh, h);
+        result.push_back(std::move(fresh));
+    }
+
+    return result;
+}
+
+template<typename T>
+typename RRBVector<T>::node_list
+RRBVector<T>::concat_nodes(node_ptr const& left, std::size_t hl,
+                           node_ptr const& right, std::size_t hr)
+{
+    //return nodes of height max(hl, hr) holding left ++ right
+    if(hl > hr){
+        node_list all(left->children.begin(), left->children.end() - 1);
+        node_list mid = concat_nodes(left->children.back(), hl - 1, right, hr);
+        all.insert(all.end(), mid.begin(), mid.end());
+        return pack(rebalance(all, hl - 1), hl);
+    }
+
+    if(hl < hr){
+        node_list all = concat_nodes(left, hl, right->children.front(), hr - 1);
+        all.insert(all.end(), right->children.begin() + 1, right->children.end());
+        return pack(rebalance(all, hr - 1), hr);
+    }
+
+    if(hl == 0){
+        if(left->items.size() + right->items.size() > BRANCH)
+            return node_list{left, right};
+
+        node_ptr leaf = std::make_shared<node>(*left);
+        leaf->items.insert(leaf->items.end(),
+                           right->items.begin(), right->items.end());
+        return node_list{leaf};
+    }
+
+    node_list all(left->children.begin(), left->children.end() - 1);
+    node_list mid = concat_nodes(left->children.back(), hl - 1,
+                                 right->children.front(), hr - 1);
+    all.insert(all.end(), mid.begin(), mid.end());
+    all.insert(all.end(), right->children.begin() + 1, right->children.end());
+    return pack(rebalance(all, hl - 1), hl);
+}
+
+template<typename T>
+void RRBVector<T>::append(RRBVector const& other)
+{
+    if(other.count == 0)
+        return;
+
+    if(count == 0){
+        *this = other;
+        return;
+    }
+
+    std::size_t h = height > other.height ? height : other.height;
+    node_list nodes = concat_nodes(root, height, other.root, other.height);
+
+    while(nodes.size() > 1)
+        nodes = pack(nodes, ++h);
+
+    root = std::move(nodes.front());
+    height = h;
+    count += other.count;
+    collapse_root();
+}
+
+template<typename T>
+typename RRBVector<T>::node_ptr
+RRBVector<T>::take_node(node_ptr const& n, std::size_t h, std::size_t keep)
+{
+    //first keep (>= 1) values of subtree n
+    if(keep == total(*n, h))
+        return n;
+
+    node_ptr result = std::make_shared<node>();
+    if(h == 0){
+        result->items.assign(n->items.begin(), n->items.begin() + keep);
+        return result;
+    }
+
+    std::size_t idx = child_index(*n, h, keep - 1);
+    std::size_t before = idx > 0 ? n->sizes[idx - 1] : 0;
+
+    result->children.assign(n->children.begin(), n->children.begin() + idx);
+    result->children.push_back(take_node(n->children[idx], h - 1, keep - before));
+    update_sizes(*result, h);
+    return result;
+}
+
+template<typename T>
+typename RRBVector<T>::node_ptr
+RRBVector<T>::drop_node(node_ptr const& n, std::size_t h, std::size_t skip)
+{
+    //subtree n without its first skip (< total) values
+    if(skip == 0)
+        return n;
+
+    node_ptr result = std::make_shared<node>();
+    if(h == 0){
+        result->items.assign(n->items.begin() + skip, n->items.end());
+        return result;
+    }
+
+    std::size_t idx = child_index(*n, h, skip);
+    std::size_t before = idx > 0 ? n->sizes[idx - 1] : 0;
+
+    result->children.push_back(drop_node(n->children[idx], h - 1, skip - before));
+    result->children.insert(result->children.end(),
+                            n->children.begin() + idx + 1, n->children.end());
+    update_sizes(*result, h);
+    return result;
+}
+
+template<typename T>
+void RRBVector<T>::collapse_root()
+{
+    //remove single-child levels above the root
+    while(height > 0 && root->children.size() == 1){
+        node_ptr child = root->children.front();
+        root = std::move(child);
+        --height;
+    }
+}
+
+template<typename T>
+void RRBVector<T>::take(std::size_t n)
+{
+    if(n >= count)
+        return;
+
+    if(n == 0){
+        clear();
+        return;
+    }
+
+    root = take_node(root, height, n);
+    count = n;
+    collapse_root();
+}
+
+template<typename T>
+void RRBVector<T>::drop(std::size_t n)
+{
+    if(n == 0)
+        return;
+
+    if(n >= count){
+        clear();
+        return;
+    }
+
+    root = drop_node(root, height, n);
+    count -= n;
+    collapse_root();
+}
+
+template<typename T>
+RRBVector<T> RRBVector<T>::slice(std::size_t begin, std::size_t end) const
+{
+    RRBVector result{*this};
+    result.take(end);
+    result.drop(begin);
+    return result;
+}
+
+template<typename T>
+void RRBVector<T>::clear()
+{
+    root.reset();
+    height = 0;
+    count = 0;
+}
+
+#endif //RRB_VECTOR_H
@@ -0,0 +1,190 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+#include <cstddef>
+#include <cstdint>
+
+//Linear search kernels over arrays of 64-bit values
+//  - find returns the index of the first match, or n when there is none
+//  - count returns the number of matches
+//
+//On x86-64 with GCC/Clang an AVX2 version (4 lanes per compare) is selected
+//at runtime when the CPU supports it, otherwise a scalar loop is used.
+//Pointers are searched as 64-bit words (identity comparison).
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_SEARCH_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace simd_search
+{
+
+template<typename T>
+    std::ptrdiff_t find_scalar(T const* data, std::ptrdiff_t n, T key)
+    {
+        for(std::ptrdiff_t i = 0; i < n; ++i)
+            if(data[i] == key)
+                return i;
+        return n;
+    }
+
+template<typename T>
+    std::ptrdiff_t count_scalar(T const* data, std::ptrdiff_t n, T key)
+    {
+        std::ptrdiff_t result = 0;
+        for(std::ptrdiff_t i = 0; i < n; ++i)
+            result += data[i] == key;
+        return result;
+    }
+
+#ifdef SIMD_SEARCH_AVX2
+
+inline bool has_avx2()
+{
+    static bool const result = __builtin_cpu_supports("avx2");
+    return result;
+}
+
+//lanes of cmp are all ones (match) or all zeros
+__attribute__((target("avx2")))
+inline int match_mask(__m256i cmp)
+{
+    return _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+}
+
+__attribute__((target("avx2")))
+inline __m256i compare(__m256i values, __m256i needle)
+{
+    return _mm256_cmpeq_epi64(values, needle);
+}
+
+__attribute__((target("avx2")))
+inline __m256i compare(__m256d values, __m256d needle)
+{
+    return _mm256_castpd_si256(_mm256_cmp_pd(values, needle, _CMP_EQ_OQ));
+}
+
+__attribute__((target("avx2")))
+inline __m256i load(std::uint64_t const* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+}
+
+__attribute__((target("avx2")))
+inline __m256d load(double const* p)
+{
+    return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2")))
+inline __m256i broadcast(std::uint64_t key)
+{
+    return _mm256_set1_epi64x(static_cast<long long>(key));
+}
+
+__attribute__((target("avx2")))
+inline __m256d broadcast(double key)
+{
+    return _mm256_set1_pd(key);
+}
+
+template<typename T>
+    __attribute__((target("avx2")))
+    std::ptrdiff_t find_avx2(T const* data, std::ptrdiff_t n, T key)
+    {
+        auto needle = broadcast(key);
+        std::ptrdiff_t i = 0;
+
+        //16 values per iteration, locate the exact lane below
+        for(; i + 16 <= n; i += 16){
+            __m256i any = _mm256_or_si256(
+                    _mm256_or_si256(compare(load(data + i), needle),
+                                    compare(load(data + i + 4), needle)),
+                    _mm256_or_si256(compare(load(data + i + 8), needle),
+                                    compare(load(data + i + 12), needle)));
+            if(!_mm256_testz_si256(any, any))
+                break;
+        }
+
+        for(; i + 4 <= n; i += 4){
+            int mask = match_mask(compare(load(data + i), needle));
+            if(mask)
+                return i + __builtin_ctz(mask);
+        }
+
+        return i + find_scalar(data + i, n - i, key);
+    }
+
+template<typename T>
+    __attribute__((target("avx2")))
+    std::ptrdiff_t count_avx2(T const* data, std::ptrdiff_t n, T key)
+    {
+        auto needle = broadcast(key);
+        __m256i acc = _mm256_setzero_si256();
+        std::ptrdiff_t i = 0;
+
+        //matching lanes are -1, subtracting them counts matches per lane
+        for(; i + 4 <= n; i += 4)
+            acc = _mm256_sub_epi64(acc, compare(load(data + i), needle));
+
+        alignas(32) std::int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+                + count_scalar(data + i, n - i, key);
+    }
+
+#endif //SIMD_SEARCH_AVX2
+
+inline std::ptrdiff_t find(std::uint64_t const* data, std::ptrdiff_t n,
+                           std::uint64_t key)
+{
+#ifdef SIMD_SEARCH_AVX2
+    if(has_avx2())
+        return find_avx2(data, n, key);
+#endif
+    return find_scalar(data, n, key);
+}
+
+inline std::ptrdiff_t find(double const* data, std::ptrdiff_t n, double key)
+{
+#ifdef SIMD_SEARCH_AVX2
+    if(has_avx2())
+        return find_avx2(data, n, key);
+#endif
+    return find_scalar(data, n, key);
+}
+
+inline std::ptrdiff_t count(std::uint64_t const* data, std::ptrdiff_t n,
+                            std::uint64_t key)
+{
+#ifdef SIMD_SEARCH_AVX2
+    if(has_avx2())
+        return count_avx2(data, n, key);
+#endif
+    return count_scalar(data, n, key);
+}
+
+inline std::ptrdiff_t count(double const* data, std::ptrdiff_t n, double key)
+{
+#ifdef SIMD_SEARCH_AVX2
+    if(has_avx2())
+        return count_avx2(data, n, key);
+#endif
+    return count_scalar(data, n, key);
+}
+
+//identity search over an array of pointers
+template<typename T>
+    std::ptrdiff_t find_pointer(T* const* data, std::ptrdiff_t n, T* key)
+    {
+        if constexpr(sizeof(T*) == sizeof(std::uint64_t))
+            return find(reinterpret_cast<std::uint64_t const*>(data), n,
+                        reinterpret_cast<std::uint64_t>(key));
+        else
+            return find_scalar(data, n, key);
+    }
+
+}; //namespace simd_search
+
+#endif //SIMD_SEARCH_H
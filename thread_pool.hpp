@@ -0,0 +1,164 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads running data parallel loops
+//  - parallel_for(n, f) calls f(0) ... f(n - 1) on the workers and on the
+//    calling thread, and returns once every call finished
+//  - the first exception thrown by f is rethrown in the calling thread
+//  - the calling thread always takes part, so concurrent loops started
+//    from several threads make progress even when all workers are busy
+//
+//f must not start another parallel_for on the same pool.
+
+class Thread_Pool
+{
+public:
+    //ctors, assignments, dtor
+    explicit Thread_Pool(std::size_t n_workers);
+    Thread_Pool(Thread_Pool const&) = delete;
+    Thread_Pool& operator=(Thread_Pool const&) = delete;
+    Thread_Pool(Thread_Pool&&) = delete;
+    Thread_Pool& operator=(Thread_Pool&&) = delete;
+    ~Thread_Pool();
+
+    //operations
+    std::size_t concurrency() const {return workers.size() + 1;};
+    template<typename F>
+        void parallel_for(std::size_t n, F f);
+
+private:
+    //helpers
+    void run_worker();
+    void submit(std::function<void()> task);
+
+    //member data
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable has_task;
+    bool stopping;
+};
+
+inline Thread_Pool::Thread_Pool(std::size_t n_workers): workers{}, tasks{}, stopping{false}
+{
+    workers.reserve(n_workers);
+    for(std::size_t i = 0; i < n_workers; ++i)
+        workers.emplace_back(&Thread_Pool::run_worker, this);
+}
+
+inline Thread_Pool::~Thread_Pool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    has_task.notify_all();
+
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+inline void Thread_Pool::run_worker()
+{
+    for(;;){
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            has_task.wait(lock, [this] {return stopping || !tasks.empty();});
+
+            if(tasks.empty())
+                return;     //stopping and drained
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+inline void Thread_Pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        tasks.push_back(std::move(task));
+    }
+    has_task.notify_one();
+}
+
+template<typename F>
+void Thread_Pool::parallel_for(std::size_t n, F f)
+{
+    if(n == 0)
+        return;
+
+    if(n == 1 || workers.empty()){
+        for(std::size_t i = 0; i < n; ++i)
+            f(i);
+        return;
+    }
+
+    //indices are handed out one at a time, helpers report when they leave
+    std::atomic<std::size_t> next{0};
+    std::size_t helpers = n - 1 < workers.size() ? n - 1 : workers.size();
+    std::size_t finished = 0;
+    std::exception_ptr error;
+    std::mutex state_mutex;
+    std::condition_variable all_finished;
+
+    auto body = [&]()
+    {
+        std::size_t i;
+        while((i = next.fetch_add(1)) < n){
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{state_mutex};
+                if(!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::size_t submitted = 0;
+    try
+    {
+        for(; submitted < helpers; ++submitted)
+            submit([&]()
+                   {
+                       body();
+                       std::lock_guard<std::mutex> lock{state_mutex};
+                       if(++finished == helpers)
+                           all_finished.notify_one();
+                   });
+    }
+    catch (...)
+    {
+        //out of memory while queueing, go on with the helpers submitted
+        std::lock_guard<std::mutex> lock{state_mutex};
+        helpers = submitted;
+    }
+
+    body();
+
+    {
+        std::unique_lock<std::mutex> lock{state_mutex};
+        all_finished.wait(lock, [&] {return finished == helpers;});
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,288 @@
+#ifndef TIMSORT_H
+#define TIMSORT_H
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+//Stable adaptive merge sort in the spirit of CPython's listsort
+//  - natural runs (non-descending or strictly descending) are detected
+//  - short runs are extended to minrun with binary insertion sort
+//  - runs are merged following Timsort's stack invariants
+//  - before each merge, galloping trims the prefix of the left run and
+//    the suffix of the right run that are already in place
+//
+//less(a, b) must be a strict weak ordering. It may throw, in which case the
+//range is left with an unspecified arrangement of (possibly duplicated)
+//values, so callers that own resources should sort a scratch copy.
+
+template<typename RandomIt, typename Less>
+class Timsort
+{
+public:
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    using diff_t = std::ptrdiff_t;
+
+    Timsort(Less less): less{less}, runs{}, tmp{} {};
+    Timsort(Timsort const&) = delete;
+    Timsort& operator=(Timsort const&) = delete;
+
+    void sort(RandomIt first, RandomIt last);
+
+private:
+    struct run
+    {
+        RandomIt base;
+        diff_t len;
+    };
+
+    //helpers
+    static diff_t minrun(diff_t n);
+    diff_t count_run(RandomIt lo, RandomIt hi);
+    void binary_insertion(RandomIt lo, RandomIt start, RandomIt hi);
+    diff_t gallop_right(value_type const& key, RandomIt base, diff_t len);
+    diff_t gallop_left(value_type const& key, RandomIt base, diff_t len);
+    void merge_collapse();
+    void merge_force_collapse();
+    void merge_at(std::size_t i);
+    void merge_lo(RandomIt a, diff_t na, RandomIt b, diff_t nb);
+    void merge_hi(RandomIt a, diff_t na, RandomIt b, diff_t nb);
+
+    //member data
+    Less less;
+    std::vector<run> runs;
+    std::vector<value_type> tmp;
+};
+
+template<typename RandomIt, typename Less>
+typename Timsort<RandomIt, Less>::diff_t
+Timsort<RandomIt, Less>::minrun(diff_t n)
+{
+    //take the 6 most significant bits of n, add 1 if any remaining bit is set
+    diff_t r = 0;
+    while(n >= 64){
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+template<typename RandomIt, typename Less>
+typename Timsort<RandomIt, Less>::diff_t
+Timsort<RandomIt, Less>::count_run(RandomIt lo, RandomIt hi)
+{
+    //return length of the run starting at lo, descending runs are reversed
+    RandomIt cur = lo + 1;
+    if(cur == hi)
+        return 1;
+
+    if(less(*cur, *lo)){
+        //strictly descending, so reversing keeps stability
+        while(++cur != hi && less(*cur, *(cur - 1)))
+            ;//Empty loop body
+        std::reverse(lo, cur);
+    } else {
+        while(++cur != hi && !less(*cur, *(cur - 1)))
+            ;//Empty loop body
+    }
+
+    return cur - lo;
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::binary_insertion(RandomIt lo, RandomIt start,
+                                               RandomIt hi)
+{
+    //[lo, start) is already sorted
+    for(; start != hi; ++start){
+        value_type pivot = std::move(*start);
+
+        //upper bound keeps equal elements in original order
+        RandomIt l = lo, r = start;
+        while(l < r){
+            RandomIt mid = l + (r - l) / 2;
+            if(less(pivot, *mid))
+                r = mid;
+            else
+                l = mid + 1;
+        }
+
+        std::move_backward(l, start, start + 1);
+        *l = std::move(pivot);
+    }
+}
+
+template<typename RandomIt, typename Less>
+typename Timsort<RandomIt, Less>::diff_t
+Timsort<RandomIt, Less>::gallop_right(value_type const& key, RandomIt base,
+                                      diff_t len)
+{
+    //number of elements in base[0, len) which are <= key
+    diff_t last = 0, ofs = 1;
+    while(ofs < len && !less(key, base[ofs - 1])){
+        last = ofs;
+        ofs = 2 * ofs + 1;
+    }
+    if(ofs > len)
+        ofs = len;
+
+    //answer lies in [last, ofs], finish with binary search
+    RandomIt it = std::upper_bound(base + last, base + ofs, key,
+                                   [this](value_type const& a, value_type const& b)
+                                   { return less(a, b); });
+    return it - base;
+}
+
+template<typename RandomIt, typename Less>
+typename Timsort<RandomIt, Less>::diff_t
+Timsort<RandomIt, Less>::gallop_left(value_type const& key, RandomIt base,
+                                     diff_t len)
+{
+    //number of elements in base[0, len) which are < key, searched from the end
+    diff_t last = 0, ofs = 1;
+    while(ofs < len && !less(base[len - ofs], key)){
+        last = ofs;
+        ofs = 2 * ofs + 1;
+    }
+    if(ofs > len)
+        ofs = len;
+
+    //answer lies in [len - ofs, len - last]
+    RandomIt it = std::lower_bound(base + (len - ofs), base + (len - last), key,
+                                   [this](value_type const& a, value_type const& b)
+                                   { return less(a, b); });
+    return it - base;
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::merge_lo(RandomIt a, diff_t na,
+                                       RandomIt b, diff_t nb)
+{
+    //left run is the smaller one: copy it out and merge from the front
+    tmp.assign(std::make_move_iterator(a), std::make_move_iterator(a + na));
+    auto t = tmp.begin(), tend = tmp.end();
+    RandomIt dest = a, bend = b + nb;
+
+    while(t != tend && b != bend){
+        if(less(*b, *t))
+            *dest++ = std::move(*b++);
+        else
+            *dest++ = std::move(*t++);
+    }
+    std::move(t, tend, dest);
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::merge_hi(RandomIt a, diff_t na,
+                                       RandomIt b, diff_t nb)
+{
+    //right run is the smaller one: copy it out and merge from the back
+    tmp.assign(std::make_move_iterator(b), std::make_move_iterator(b + nb));
+    auto t = tmp.end(), tbegin = tmp.begin();
+    RandomIt dest = b + nb, acur = a + na;
+
+    while(t != tbegin && acur != a){
+        if(less(*(t - 1), *(acur - 1)))
+            *--dest = std::move(*--acur);
+        else
+            *--dest = std::move(*--t);
+    }
+    std::move_backward(tbegin, t, dest);
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::merge_at(std::size_t i)
+{
+    RandomIt a = runs[i].base, b = runs[i + 1].base;
+    diff_t na = runs[i].len, nb = runs[i + 1].len;
+
+    runs[i].len = na + nb;
+    runs.erase(runs.begin() + i + 1);
+
+    //elements of a already <= b[0] are in place
+    diff_t k = gallop_right(*b, a, na);
+    a += k;
+    na -= k;
+    if(na == 0)
+        return;
+
+    //elements of b already >= a[last] are in place
+    nb = gallop_left(*(a + na - 1), b, nb);
+    if(nb == 0)
+        return;
+
+    if(na <= nb)
+        merge_lo(a, na, b, nb);
+    else
+        merge_hi(a, na, b, nb);
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::merge_collapse()
+{
+    //restore invariants on the run stack (with the 2015 fix for deep stacks)
+    while(runs.size() > 1){
+        std::size_t n = runs.size() - 2;
+        if((n > 0 && runs[n - 1].len <= runs[n].len + runs[n + 1].len)
+           || (n > 1 && runs[n - 2].len <= runs[n - 1].len + runs[n].len)){
+            if(runs[n - 1].len < runs[n + 1].len)
+                --n;
+        } else if(runs[n].len > runs[n + 1].len) {
+            break;
+        }
+        merge_at(n);
+    }
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::merge_force_collapse()
+{
+    while(runs.size() > 1){
+        std::size_t n = runs.size() - 2;
+        if(n > 0 && runs[n - 1].len < runs[n + 1].len)
+            --n;
+        merge_at(n);
+    }
+}
+
+template<typename RandomIt, typename Less>
+void Timsort<RandomIt, Less>::sort(RandomIt first, RandomIt last)
+{
+    diff_t remaining = last - first;
+    if(remaining < 2)
+        return;
+
+    diff_t min_len = minrun(remaining);
+    RandomIt lo = first;
+    runs.clear();
+
+    while(remaining > 0){
+        diff_t n = count_run(lo, last);
+
+        //extend short run to min(min_len, remaining)
+        if(n < min_len){
+            diff_t force = remaining < min_len ? remaining : min_len;
+            binary_insertion(lo, lo + n, lo + force);
+            n = force;
+        }
+
+        runs.push_back(run{lo, n});
+        merge_collapse();
+
+        lo += n;
+        remaining -= n;
+    }
+
+    merge_force_collapse();
+}
+
+//helper function to sort with deduced template arguments
+template<typename RandomIt, typename Less>
+    void timsort(RandomIt first, RandomIt last, Less less)
+    {
+        Timsort<RandomIt, Less> sorter{less};
+        sorter.sort(first, last);
+    }
+
+#endif //TIMSORT_H
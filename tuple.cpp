@@ -1,106 +1,1073 @@
 /*** A simplified version of C++ standard tuple ***/
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#include "column_kernels.hpp"
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+#if __has_include(<compare>)
+#include <compare>
+#endif
 
 namespace
 {
     using size_t = unsigned long;
 };
 
+#ifndef __has_builtin
+#define __has_builtin(x) 0
+#endif
+
 //Define helper class to get element type from a variadic template
-template<size_t idx, typename t, typename... Types>
-    struct _Tuple_element
+//Lookup is flat, no template is instantiated per preceding element:
+//  - the compiler builtin __type_pack_element when there is one
+//  - otherwise overload resolution picks the base _Indexed<idx, T> of
+//    a class deriving from every (index, type) pair
+template<size_t idx, typename T>
+    struct _Indexed
     {
-        using type = typename _Tuple_element<idx - 1, Types...>::type;
+        using type = T;
     };
 
-template<typename T, typename... Types>
-    struct _Tuple_element<0ul, T, Types...>
+template<typename Seq, typename... Types>
+    struct _Indexed_all;
+
+template<size_t... I, typename... Types>
+    struct _Indexed_all<std::index_sequence<I...>, Types...>: _Indexed<I, Types>... {};
+
+template<size_t idx, typename T>
+    _Indexed<idx, T> _Select_indexed(_Indexed<idx, T> const&);
+
+template<size_t idx, typename... Types>
+    struct _Tuple_element
     {
-        using type = T;
+        static_assert(idx < sizeof...(Types), "Index Overflow");
+
+#if __has_builtin(__type_pack_element)
+        using type = __type_pack_element<idx, Types...>;
+#else
+        using type = typename decltype(_Select_indexed<idx>(
+                _Indexed_all<std::index_sequence_for<Types...>, Types...>{}))::type;
+#endif
     };
 
-template<size_t idx, typename T, typename... Types>
-    using _Tuple_element_t = typename _Tuple_element<idx, T, Types...>::type;
+template<size_t idx, typename... Types>
+    using _Tuple_element_t = typename _Tuple_element<idx, Types...>::type;
 
-//Helper class to implement tuple
-template<size_t idx, typename T>
+//Index of the first U in Types, sizeof...(Types) if there is none
+template<typename U, typename... Types>
+    constexpr size_t _Find_type()
+    {
+        constexpr bool matches[] = {std::is_same_v<U, Types>..., false};
+        for(size_t i = 0; i < sizeof...(Types); ++i)
+            if(matches[i])
+                return i;
+        return sizeof...(Types);
+    }
+
+template<typename U, typename... Types>
+    constexpr size_t _Count_type = (size_t{0} + ... + size_t{std::is_same_v<U, Types>});
+
+//Keeps forwarding constructors from taking over copy and move of Class
+template<typename Class, typename U>
+    using _Not_derived = std::enable_if_t<!std::is_base_of_v<Class, std::remove_cv_t<std::remove_reference_t<U>>>>;
+
+//Helper class to implement tuple, the element is constructed once
+//from the forwarded argument
+template<size_t idx, typename T, bool = std::is_empty_v<T> && !std::is_final_v<T>>
     struct _Head_Base
     {
-        explicit _Head_Base(T arg): value{arg} {};
-        operator T() {return value;};
+        constexpr _Head_Base(): value() {};
+
+        template<typename U, typename = _Not_derived<_Head_Base, U>>
+            constexpr explicit _Head_Base(U&& arg): value(std::forward<U>(arg)) {};
+
+        static constexpr T& _M_head(_Head_Base& b) noexcept {return b.value;};
+        static constexpr T const& _M_head(_Head_Base const& b) noexcept {return b.value;};
+
         T value;
     };
 
-//_Tuple_impl is defined recursively
-template<size_t idx, typename T, typename... Types>
-    struct _Tuple_impl: public _Head_Base<idx, T>, public _Tuple_impl<idx + 1, Types...>
+//Empty elements (allocators, comparators, tags) are a base instead of a
+//member, so they take no space (empty base optimization)
+template<size_t idx, typename T>
+    struct _Head_Base<idx, T, true>: public T
     {
-        using _Base = _Head_Base<idx, T>;
-        using _Inherited = _Tuple_impl<idx + 1, Types...>;
-        explicit _Tuple_impl(T first_arg, Types... args): _Base{first_arg}, _Inherited{args...} {};
+        constexpr _Head_Base(): T() {};
 
-        template<size_t __id, typename U, typename... UTypes>
-        friend std::ostream& operator<<(std::ostream& os, _Tuple_impl<__id, U, UTypes...> const& t);
+        template<typename U, typename = _Not_derived<_Head_Base, U>>
+            constexpr explicit _Head_Base(U&& arg): T(std::forward<U>(arg)) {};
+
+        static constexpr T& _M_head(_Head_Base& b) noexcept {return b;};
+        static constexpr T const& _M_head(_Head_Base const& b) noexcept {return b;};
     };
 
+//Reference elements assign through the reference like std::tuple, so a
+//Tuple of references works as a proxy to elements stored elsewhere
 template<size_t idx, typename T>
-    struct _Tuple_impl<idx, T>: public _Head_Base<idx, T>
+    struct _Head_Base<idx, T&, false>
     {
-        using _Base = _Head_Base<idx, T>;
-        _Tuple_impl(T arg): _Base{arg} {};
+        template<typename U, typename = _Not_derived<_Head_Base, U>>
+            constexpr explicit _Head_Base(U&& arg): value(std::forward<U>(arg)) {};
+
+        constexpr _Head_Base(_Head_Base const&) = default;
+        constexpr _Head_Base& operator=(_Head_Base const& other)
+        {
+            value = other.value;
+            return *this;
+        };
+
+        static constexpr T& _M_head(_Head_Base const& b) noexcept {return b.value;};
+
+        T& value;
+    };
+
+//_Tuple_impl derives from the _Head_Base of every element at once, so
+//the inheritance depth stays the same whatever the number of elements
+template<typename Seq, typename... Types>
+    struct _Tuple_impl;
+
+template<size_t... I, typename... Types>
+    struct _Tuple_impl<std::index_sequence<I...>, Types...>: public _Head_Base<I, Types>...
+    {
+        constexpr _Tuple_impl() = default;
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !(sizeof...(UTypes) == 1
+                                                  && (std::is_base_of_v<_Tuple_impl, std::decay_t<UTypes>> && ...))>>
+            constexpr explicit _Tuple_impl(UTypes&&... args)
+                : _Head_Base<I, Types>(std::forward<UTypes>(args))... {};
     };
 
 //tuple class
 template<typename... Types>
-    class Tuple: public _Tuple_impl<0ul, Types...>
+    class Tuple: public _Tuple_impl<std::index_sequence_for<Types...>, Types...>
     {
+        //every element can be made from its UArgs; a one-element Tuple
+        //which can be made from From as a whole leaves it to the
+        //forwarding constructor, so Tuple<Tuple<T>> wraps a Tuple<T>
+        template<typename From, typename... UArgs>
+            static constexpr bool _Converting
+                = (std::is_constructible_v<Types, UArgs> && ...)
+                  && (sizeof...(Types) != 1
+                      || ((!std::is_convertible_v<From, Types> && !std::is_constructible_v<Types, From>
+                           && !std::is_same_v<Types, std::decay_t<UArgs>>) && ...));
+
+        template<typename... UArgs>
+            static constexpr bool _Implicit = (std::is_convertible_v<UArgs, Types> && ...);
+
     public:
-        using _Impl = _Tuple_impl<0ul, Types...>;
-        explicit Tuple(Types... args): _Impl{args...} {};
+        using _Impl = _Tuple_impl<std::index_sequence_for<Types...>, Types...>;
+
+        //ctors, assignments
+        //copy and move are implicit, so they copy or move each element once
+        //and are trivial (memcpy) when they are trivial for every element
+        constexpr Tuple() = default;
+
+        //elements are constructed in place from forwarded arguments
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !(sizeof...(UTypes) == 1
+                                                  && (std::is_base_of_v<Tuple, std::decay_t<UTypes>> && ...))>,
+                 typename = std::enable_if_t<(std::is_constructible_v<Types, UTypes&&> && ...)>>
+            constexpr explicit Tuple(UTypes&&... args): _Impl(std::forward<UTypes>(args)...) {};
+
+        //converting copy and move from a Tuple of other element types, as
+        //for std::tuple they are explicit unless every element converts
+        //implicitly (one overload each way, explicit(bool) is C++20)
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>,
+                 std::enable_if_t<_Converting<Tuple<UTypes...> const&, UTypes const&...>
+                                  && _Implicit<UTypes const&...>, bool> = true>
+            constexpr Tuple(Tuple<UTypes...> const& other)
+                : Tuple(other, std::index_sequence_for<Types...>{}) {};
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>,
+                 std::enable_if_t<_Converting<Tuple<UTypes...> const&, UTypes const&...>
+                                  && !_Implicit<UTypes const&...>, bool> = false>
+            constexpr explicit Tuple(Tuple<UTypes...> const& other)
+                : Tuple(other, std::index_sequence_for<Types...>{}) {};
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>,
+                 std::enable_if_t<_Converting<Tuple<UTypes...>&&, UTypes&&...>
+                                  && _Implicit<UTypes&&...>, bool> = true>
+            constexpr Tuple(Tuple<UTypes...>&& other)
+                : Tuple(std::move(other), std::index_sequence_for<Types...>{}) {};
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>,
+                 std::enable_if_t<_Converting<Tuple<UTypes...>&&, UTypes&&...>
+                                  && !_Implicit<UTypes&&...>, bool> = false>
+            constexpr explicit Tuple(Tuple<UTypes...>&& other)
+                : Tuple(std::move(other), std::index_sequence_for<Types...>{}) {};
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>>
+            constexpr Tuple& operator=(Tuple<UTypes...> const& other)
+            {
+                _M_assign(other, std::index_sequence_for<Types...>{});
+                return *this;
+            }
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !std::is_same_v<Tuple<UTypes...>, Tuple>>>
+            constexpr Tuple& operator=(Tuple<UTypes...>&& other)
+            {
+                _M_assign(std::move(other), std::index_sequence_for<Types...>{});
+                return *this;
+            }
+
+    private:
+        //helpers, element I of other is copied or moved as the value
+        //category of other says
+        template<typename... UTypes, size_t... I>
+            constexpr Tuple(Tuple<UTypes...> const& other, std::index_sequence<I...>)
+                : _Impl(_Head_Base<I, UTypes>::_M_head(other)...) {};
+
+        template<typename... UTypes, size_t... I>
+            constexpr Tuple(Tuple<UTypes...>&& other, std::index_sequence<I...>)
+                : _Impl(std::forward<UTypes>(_Head_Base<I, UTypes>::_M_head(other))...) {};
+
+        template<typename... UTypes, size_t... I>
+            constexpr void _M_assign(Tuple<UTypes...> const& other, std::index_sequence<I...>)
+            {
+                ((_Head_Base<I, Types>::_M_head(*this) = _Head_Base<I, UTypes>::_M_head(other)), ...);
+            }
+
+        template<typename... UTypes, size_t... I>
+            constexpr void _M_assign(Tuple<UTypes...>&& other, std::index_sequence<I...>)
+            {
+                ((_Head_Base<I, Types>::_M_head(*this)
+                  = std::forward<UTypes>(_Head_Base<I, UTypes>::_M_head(other))), ...);
+            }
+    };
+
+//Tuple{args...} holds copies of args
+template<typename... Types>
+    Tuple(Types...) -> Tuple<Types...>;
+
+
+//get tuple element by index, the tuple is accessed in place through
+//its _Head_Base, an rvalue tuple hands out an rvalue element
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...>& get(Tuple<Types...>& t) noexcept
+    {
+        using _Head = _Head_Base<idx, _Tuple_element_t<idx, Types...>>;
+        return _Head::_M_head(t);
+    }
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...> const& get(Tuple<Types...> const& t) noexcept
+    {
+        using _Head = _Head_Base<idx, _Tuple_element_t<idx, Types...>>;
+        return _Head::_M_head(t);
+    }
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...>&& get(Tuple<Types...>&& t) noexcept
+    {
+        using _RetType = _Tuple_element_t<idx, Types...>;
+        return std::forward<_RetType>(get<idx>(t));
+    }
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...> const&& get(Tuple<Types...> const&& t) noexcept
+    {
+        using _RetType = _Tuple_element_t<idx, Types...>;
+        return std::forward<_RetType const>(get<idx>(t));
+    }
+
+//get tuple element by type, the type must occur exactly once
+template<typename U, typename... Types>
+    constexpr U& get(Tuple<Types...>& t) noexcept
+    {
+        static_assert(_Count_type<U, Types...> == 1, "Type must occur exactly once");
+        return get<_Find_type<U, Types...>()>(t);
+    }
+
+template<typename U, typename... Types>
+    constexpr U const& get(Tuple<Types...> const& t) noexcept
+    {
+        static_assert(_Count_type<U, Types...> == 1, "Type must occur exactly once");
+        return get<_Find_type<U, Types...>()>(t);
+    }
+
+template<typename U, typename... Types>
+    constexpr U&& get(Tuple<Types...>&& t) noexcept
+    {
+        static_assert(_Count_type<U, Types...> == 1, "Type must occur exactly once");
+        return get<_Find_type<U, Types...>()>(std::move(t));
+    }
+
+template<typename U, typename... Types>
+    constexpr U const&& get(Tuple<Types...> const&& t) noexcept
+    {
+        static_assert(_Count_type<U, Types...> == 1, "Type must occur exactly once");
+        return get<_Find_type<U, Types...>()>(std::move(t));
+    }
+
+//Element order of a Packed_Tuple: by decreasing alignment, equal
+//alignments keep their declaration order
+//  - slot[j] is the element stored at position j
+//  - position[i] is where element i is stored
+template<typename... Types>
+    struct _Packed_order
+    {
+        static constexpr size_t size = sizeof...(Types);
+        static constexpr std::array<size_t, size> align = {alignof(Types)...};
 
-        friend std::ostream& operator<<(std::ostream& os, Tuple<Types...> const& t)
+        static constexpr std::array<size_t, size> _M_slots()
         {
-            os << static_cast<_Impl>(t);
-            return os;
+            std::array<size_t, size> result{};
+            for(size_t i = 0; i < size; ++i){
+                size_t j = i;
+                for(; j > 0 && align[result[j - 1]] < align[i]; --j)
+                    result[j] = result[j - 1];
+                result[j] = i;
+            }
+            return result;
         }
+
+        static constexpr std::array<size_t, size> _M_positions()
+        {
+            std::array<size_t, size> result{};
+            for(size_t j = 0; j < size; ++j)
+                result[_M_slots()[j]] = j;
+            return result;
+        }
+
+        static constexpr std::array<size_t, size> slot = _M_slots();
+        static constexpr std::array<size_t, size> position = _M_positions();
+    };
+
+template<typename Seq, typename... Types>
+    struct _Packed_storage;
+
+template<size_t... J, typename... Types>
+    struct _Packed_storage<std::index_sequence<J...>, Types...>
+    {
+        using type = Tuple<_Tuple_element_t<_Packed_order<Types...>::slot[J], Types...>...>;
+    };
+
+//Opt-in layout of a Tuple with minimal padding: elements are stored
+//sorted by alignment, get<idx> still uses the declared order
+template<typename... Types>
+    class Packed_Tuple
+    {
+    public:
+        using _Order = _Packed_order<Types...>;
+        using _Storage = typename _Packed_storage<std::index_sequence_for<Types...>, Types...>::type;
+
+        //ctors, assignments
+        constexpr Packed_Tuple() = default;
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)
+                                             && !(sizeof...(UTypes) == 1
+                                                  && (std::is_base_of_v<Packed_Tuple, std::decay_t<UTypes>> && ...))>>
+            constexpr explicit Packed_Tuple(UTypes&&... args)
+                : Packed_Tuple(Tuple<UTypes&&...>{std::forward<UTypes>(args)...},
+                               std::index_sequence_for<Types...>{}) {};
+
+        //element access
+        template<size_t idx>
+            constexpr _Tuple_element_t<idx, Types...>& _M_get() & noexcept
+            {
+                return get<_Order::position[idx]>(_M_storage);
+            }
+
+        template<size_t idx>
+            constexpr _Tuple_element_t<idx, Types...> const& _M_get() const& noexcept
+            {
+                return get<_Order::position[idx]>(_M_storage);
+            }
+
+    private:
+        //arguments are forwarded from a Tuple of references in storage order
+        template<typename... URefs, size_t... J>
+            constexpr Packed_Tuple(Tuple<URefs...>&& args, std::index_sequence<J...>)
+                : _M_storage(get<_Order::slot[J]>(std::move(args))...) {};
+
+        //member data
+        _Storage _M_storage;
     };
 
+template<typename... Types>
+    Packed_Tuple(Types...) -> Packed_Tuple<Types...>;
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...>& get(Packed_Tuple<Types...>& t) noexcept
+    {
+        return t.template _M_get<idx>();
+    }
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...> const& get(Packed_Tuple<Types...> const& t) noexcept
+    {
+        return t.template _M_get<idx>();
+    }
+
+template<size_t idx, typename... Types>
+    constexpr _Tuple_element_t<idx, Types...>&& get(Packed_Tuple<Types...>&& t) noexcept
+    {
+        using _RetType = _Tuple_element_t<idx, Types...>;
+        return std::forward<_RetType>(t.template _M_get<idx>());
+    }
+
+//Tuple protocol, enables structured bindings (get is found by ADL)
+namespace std
+{
+    template<typename... Types>
+        struct tuple_size<Tuple<Types...>>: std::integral_constant<std::size_t, sizeof...(Types)> {};
+
+    template<std::size_t idx, typename... Types>
+        struct tuple_element<idx, Tuple<Types...>>
+        {
+            using type = _Tuple_element_t<idx, Types...>;
+        };
+
+    template<typename... Types>
+        struct tuple_size<Packed_Tuple<Types...>>: std::integral_constant<std::size_t, sizeof...(Types)> {};
+
+    template<std::size_t idx, typename... Types>
+        struct tuple_element<idx, Packed_Tuple<Types...>>
+        {
+            using type = _Tuple_element_t<idx, Types...>;
+        };
+};
+
+//Types whose objects can be moved to new storage by copying their bytes,
+//the source is then dropped without running its destructor. Trivially
+//copyable types are, other types may opt in by specializing.
+template<typename T>
+    struct is_trivially_relocatable: std::is_trivially_copyable<T> {};
+
+template<typename T>
+    struct is_trivially_relocatable<T&>: std::true_type {};
 
-//get tuple element by index
-template<size_t idx, typename T, typename... Types>
-    _Tuple_element_t<idx, T, Types...> get(Tuple<T, Types...> t)
+template<typename... Types>
+    struct is_trivially_relocatable<Tuple<Types...>>
+        : std::conjunction<is_trivially_relocatable<Types>...> {};
+
+template<typename... Types>
+    struct is_trivially_relocatable<Packed_Tuple<Types...>>
+        : std::conjunction<is_trivially_relocatable<Types>...> {};
+
+template<typename T>
+    constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+//move [first, last) to the uninitialized storage at out and end the
+//lifetime of the source objects, return the end of the moved range
+//  - a single memcpy for trivially relocatable types
+//  - otherwise move construction then destruction, one object at a time
+template<typename T>
+    T* relocate(T* first, T* last, T* out) noexcept(is_trivially_relocatable_v<T>
+                                                     || std::is_nothrow_move_constructible_v<T>)
+    {
+        if constexpr(is_trivially_relocatable_v<T>){
+            size_t n = last - first;
+            if(n)
+                std::memcpy(static_cast<void*>(out), static_cast<void const*>(first), n * sizeof(T));
+            return out + n;
+        }
+        else{
+            for(; first != last; ++first, ++out){
+                ::new(static_cast<void*>(out)) T(std::move(*first));
+                first->~T();
+            }
+            return out;
+        }
+    }
+
+//call f with the elements of a tuple as arguments, an rvalue tuple
+//passes rvalue elements. Overloads on Tuple are preferred over std::apply
+//(which reaches Tuple by ADL but only knows std::get)
+template<typename F, typename Tup, size_t... I>
+    constexpr decltype(auto) _Apply_impl(F&& f, Tup&& t, std::index_sequence<I...>)
     {
-        static_assert(idx <= sizeof...(Types), "Index Overflow");
-        using _RetType = _Tuple_element_t<idx, T, Types...>;
-        using _Head = _Head_Base<idx, _RetType>;
+        return std::forward<F>(f)(get<I>(std::forward<Tup>(t))...);
+    }
+
+template<typename F, typename... Types>
+    constexpr decltype(auto) apply(F&& f, Tuple<Types...>& t)
+    {
+        return _Apply_impl(std::forward<F>(f), t, std::index_sequence_for<Types...>{});
+    }
+
+template<typename F, typename... Types>
+    constexpr decltype(auto) apply(F&& f, Tuple<Types...> const& t)
+    {
+        return _Apply_impl(std::forward<F>(f), t, std::index_sequence_for<Types...>{});
+    }
 
-        return static_cast<_Head>(t);
+template<typename F, typename... Types>
+    constexpr decltype(auto) apply(F&& f, Tuple<Types...>&& t)
+    {
+        return _Apply_impl(std::forward<F>(f), std::move(t), std::index_sequence_for<Types...>{});
     }
 
-//print all elements in a tuple
-template<size_t idx, typename T, typename... Types>
-    std::ostream& operator<<(std::ostream& os, _Tuple_impl<idx, T, Types...> const& t)
+//call f on each element in order
+template<typename Tup, typename F, size_t... I>
+    constexpr void _For_each_impl(Tup&& t, F& f, std::index_sequence<I...>)
     {
-        using _Base = _Head_Base<idx, T>;
-        os << static_cast<_Base>(t) << '\n';
+        (f(get<I>(std::forward<Tup>(t))), ...);
+    }
 
-        if constexpr(sizeof...(Types) > 0){
-            using _Inherited = _Tuple_impl<idx + 1, Types...>;
-            os << static_cast<_Inherited>(t);
+template<typename... Types, typename F>
+    constexpr void for_each(Tuple<Types...>& t, F f)
+    {
+        _For_each_impl(t, f, std::index_sequence_for<Types...>{});
+    }
+
+template<typename... Types, typename F>
+    constexpr void for_each(Tuple<Types...> const& t, F f)
+    {
+        _For_each_impl(t, f, std::index_sequence_for<Types...>{});
+    }
+
+template<typename... Types, typename F>
+    constexpr void for_each(Tuple<Types...>&& t, F f)
+    {
+        _For_each_impl(std::move(t), f, std::index_sequence_for<Types...>{});
+    }
+
+//compare tuples of the same length element by element, the first
+//pair of elements that differs decides (later pairs are not compared)
+template<typename... Types, typename... UTypes, size_t... I>
+    constexpr bool _Equal_impl(Tuple<Types...> const& a, Tuple<UTypes...> const& b,
+                               std::index_sequence<I...>)
+    {
+        return ((get<I>(a) == get<I>(b)) && ...);
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator==(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        static_assert(sizeof...(Types) == sizeof...(UTypes), "Tuples must have the same length");
+        return _Equal_impl(a, b, std::index_sequence_for<Types...>{});
+    }
+
+#ifdef __cpp_lib_three_way_comparison
+
+//element order from <=>, or from < when the element has no <=>
+struct _Synth_three_way
+{
+    template<typename T, typename U>
+        constexpr auto operator()(T const& a, U const& b) const
+        {
+            if constexpr(std::three_way_comparable_with<T, U>)
+                return a <=> b;
+            else
+                return a < b ? std::weak_ordering::less
+                     : b < a ? std::weak_ordering::greater
+                     : std::weak_ordering::equivalent;
         }
+};
+
+template<typename T, typename U>
+    using _Synth_three_way_t = decltype(_Synth_three_way{}(std::declval<T const&>(), std::declval<U const&>()));
 
+template<typename R, typename... Types, typename... UTypes, size_t... I>
+    constexpr R _Three_way_impl(Tuple<Types...> const& a, Tuple<UTypes...> const& b,
+                                std::index_sequence<I...>)
+    {
+        R result = R::equivalent;
+        (void)((result = _Synth_three_way{}(get<I>(a), get<I>(b)), result != 0) || ...);
+        return result;
+    }
+
+//<, <=, > and >= are rewritten in terms of <=>
+template<typename... Types, typename... UTypes>
+    constexpr std::common_comparison_category_t<_Synth_three_way_t<Types, UTypes>...>
+    operator<=>(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        using _Result = std::common_comparison_category_t<_Synth_three_way_t<Types, UTypes>...>;
+        return _Three_way_impl<_Result>(a, b, std::index_sequence_for<Types...>{});
+    }
+
+#else
+
+template<typename... Types, typename... UTypes, size_t... I>
+    constexpr bool _Less_impl(Tuple<Types...> const& a, Tuple<UTypes...> const& b,
+                              std::index_sequence<I...>)
+    {
+        bool result = false;
+        (void)((get<I>(a) < get<I>(b) ? (result = true)
+                : get<I>(b) < get<I>(a) ? (result = false, true)
+                : false) || ...);
+        return result;
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator!=(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        return !(a == b);
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator<(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        static_assert(sizeof...(Types) == sizeof...(UTypes), "Tuples must have the same length");
+        return _Less_impl(a, b, std::index_sequence_for<Types...>{});
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator>(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        return b < a;
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator<=(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        return !(b < a);
+    }
+
+template<typename... Types, typename... UTypes>
+    constexpr bool operator>=(Tuple<Types...> const& a, Tuple<UTypes...> const& b)
+    {
+        return !(a < b);
+    }
+
+#endif //__cpp_lib_three_way_comparison
+
+//Hash of a tuple, consistent with ==
+//  - integer elements without padding between them are hashed as the
+//    bytes of the tuple, read 8 at a time in a single pass
+//  - otherwise the std::hash of every element is mixed in order
+inline std::uint64_t _Hash_mix(std::uint64_t h, std::uint64_t w) noexcept
+{
+    w *= 0x9e3779b97f4a7c15;
+    w ^= w >> 32;
+    return (h ^ w) * 0xff51afd7ed558ccd;
+}
+
+inline size_t _Hash_bytes(void const* p, size_t n) noexcept
+{
+    auto bytes = static_cast<unsigned char const*>(p);
+    std::uint64_t h = n;
+    for(; n >= 8; bytes += 8, n -= 8){
+        std::uint64_t w;
+        std::memcpy(&w, bytes, 8);
+        h = _Hash_mix(h, w);
+    }
+    if(n){
+        std::uint64_t w = 0;
+        std::memcpy(&w, bytes, n);
+        h = _Hash_mix(h, w);
+    }
+    return h ^ (h >> 33);
+}
+
+template<typename... Types>
+    constexpr bool _Hash_as_bytes = (std::is_integral_v<Types> && ...)
+                                    && std::has_unique_object_representations_v<Tuple<Types...>>;
+
+template<typename... Types, size_t... I>
+    size_t _Hash_elements(Tuple<Types...> const& t, std::index_sequence<I...>)
+    {
+        std::uint64_t h = sizeof...(Types);
+        ((h = _Hash_mix(h, std::hash<std::remove_cv_t<std::remove_reference_t<Types>>>{}(get<I>(t)))), ...);
+        return h ^ (h >> 33);
+    }
+
+namespace std
+{
+    template<typename... Types>
+        struct hash<Tuple<Types...>>
+        {
+            size_t operator()(Tuple<Types...> const& t) const
+            {
+                if constexpr(_Hash_as_bytes<Types...>)
+                    return _Hash_bytes(&t, sizeof(t));
+                else
+                    return _Hash_elements(t, std::index_sequence_for<Types...>{});
+            }
+        };
+};
+
+//print all elements in a tuple, each followed by a line break
+template<typename... Types>
+    std::ostream& operator<<(std::ostream& os, Tuple<Types...> const& t)
+    {
+        for_each(t, [&os](auto const& element) {os << element << '\n';});
+        return os;
+    }
+
+//os << separated(t, ", ") prints the elements with separator between them
+template<typename... Types>
+    struct _Separated
+    {
+        Tuple<Types...> const& tuple;
+        std::string_view separator;
+    };
+
+template<typename... Types>
+    constexpr _Separated<Types...> separated(Tuple<Types...> const& t, std::string_view separator) noexcept
+    {
+        return _Separated<Types...>{t, separator};
+    }
+
+template<typename... Types>
+    std::ostream& operator<<(std::ostream& os, _Separated<Types...> s)
+    {
+        std::string_view separator{};
+        for_each(s.tuple, [&](auto const& element)
+                 {
+                     os << separator << element;
+                     separator = s.separator;
+                 });
         return os;
     }
 
-//helper fucntion to form a tuple
+//Write one element as operator<< would with default flags, return the
+//end of the output or nullptr if it does not fit
+inline char* _Write_chars(char* first, char* last, std::string_view text)
+{
+    if(static_cast<size_t>(last - first) < text.size())
+        return nullptr;
+    return std::copy(text.begin(), text.end(), first);
+}
+
+template<typename T>
+    char* _Write_chars(char* first, char* last, T const& value)
+    {
+        if constexpr(std::is_same_v<T, char>){
+            return _Write_chars(first, last, std::string_view{&value, 1});
+        }
+        else if constexpr(std::is_same_v<T, bool>){
+            return _Write_chars(first, last, value ? "1" : "0");
+        }
+        else if constexpr(std::is_integral_v<T>){
+            auto [ptr, ec] = std::to_chars(first, last, value);
+            return ec == std::errc{} ? ptr : nullptr;
+        }
+        else if constexpr(std::is_floating_point_v<T>){
+            auto [ptr, ec] = std::to_chars(first, last, value, std::chars_format::general, 6);
+            return ec == std::errc{} ? ptr : nullptr;
+        }
+        else{
+            static_assert(std::is_convertible_v<T const&, std::string_view>,
+                          "element cannot be written as characters");
+            return _Write_chars(first, last, std::string_view{value});
+        }
+    }
+
+//Write the elements into [first, last) with separator between them,
+//without iostream and without allocating. Like std::to_chars, returns
+//{last, value_too_large} when the buffer is too small.
+template<typename... Types>
+    std::to_chars_result to_chars(char* first, char* last, Tuple<Types...> const& t,
+                                  std::string_view separator = ", ")
+    {
+        char* pos = first;
+        std::string_view next{};
+
+        for_each(t, [&](auto const& element)
+                 {
+                     if(pos)
+                         pos = _Write_chars(pos, last, next);
+                     if(pos)
+                         pos = _Write_chars(pos, last, element);
+                     next = separator;
+                 });
+
+        if(!pos)
+            return std::to_chars_result{last, std::errc::value_too_large};
+        return std::to_chars_result{pos, std::errc{}};
+    }
+
+#ifdef __cpp_lib_format
+//std::format("{}", t) writes the elements separated by ", " straight
+//into the output iterator of the format context
+namespace std
+{
+    template<typename... Types>
+        struct formatter<Tuple<Types...>, char>
+        {
+            constexpr auto parse(std::format_parse_context& ctx) {return ctx.begin();}
+
+            template<typename FormatContext>
+                auto format(Tuple<Types...> const& t, FormatContext& ctx) const
+                {
+                    auto out = ctx.out();
+                    bool first = true;
+
+                    for_each(t, [&](auto const& element)
+                             {
+                                 if(!first)
+                                     out = std::format_to(out, ", ");
+                                 out = std::format_to(out, "{}", element);
+                                 first = false;
+                             });
+
+                    return out;
+                }
+        };
+};
+#endif //__cpp_lib_format
+
+//helper fucntion to form a tuple, lvalue arguments are copied and
+//rvalue arguments moved into their element
 template<typename... Types>
-    Tuple<std::decay_t<Types>...> make_tuple(Types const&... args)
+    constexpr Tuple<std::decay_t<Types>...> make_tuple(Types&&... args)
     {
-        return Tuple{args...};
+        return Tuple<std::decay_t<Types>...>{std::forward<Types>(args)...};
     }
 
+//Contiguous run of one column of a TupleVector
+template<typename T>
+    class Column
+    {
+    public:
+        constexpr Column(T* first, size_t n) noexcept: first{first}, n{n} {};
+
+        constexpr T* data() const noexcept {return first;};
+        constexpr size_t size() const noexcept {return n;};
+        constexpr T* begin() const noexcept {return first;};
+        constexpr T* end() const noexcept {return first + n;};
+        constexpr T& operator[](size_t i) const noexcept {return first[i];};
+
+    private:
+        T* first;
+        size_t n;
+    };
+
+//Sequence of Tuple records stored column by column (structure of arrays)
+//  - element I of every record lives in one std::vector, so a scan of a
+//    single field reads only that field and the loop can be vectorized
+//  - operator[] returns a Tuple of references to the fields of a record,
+//    get, apply, structured bindings and assignment work through it
+//  - push_back and emplace_back keep all columns the same length even
+//    when constructing an element throws
+template<typename... Types>
+    class TupleVector
+    {
+    public:
+        using value_type = Tuple<Types...>;
+        using reference = Tuple<Types&...>;
+        using const_reference = Tuple<Types const&...>;
+
+        template<typename Vec, typename Ref>
+            class _Iterator
+            {
+            public:
+                constexpr _Iterator(Vec* v, size_t i) noexcept: v{v}, i{i} {};
+
+                Ref operator*() const {return (*v)[i];};
+                _Iterator& operator++() noexcept {++i; return *this;};
+                bool operator==(_Iterator const& other) const noexcept {return i == other.i;};
+                bool operator!=(_Iterator const& other) const noexcept {return i != other.i;};
+
+            private:
+                Vec* v;
+                size_t i;
+            };
+
+        using iterator = _Iterator<TupleVector, reference>;
+        using const_iterator = _Iterator<TupleVector const, const_reference>;
+
+        //capacity
+        size_t size() const noexcept {return get<0>(columns).size();};
+        bool empty() const noexcept {return size() == 0;};
+
+        void reserve(size_t n)
+        {
+            for_each(columns, [n](auto& c) {c.reserve(n);});
+        };
+
+        //modifiers
+        void clear() noexcept
+        {
+            for_each(columns, [](auto& c) {c.clear();});
+        };
+
+        void push_back(value_type const& record)
+        {
+            apply([this](Types const&... fields) {emplace_back(fields...);}, record);
+        };
+
+        void push_back(value_type&& record)
+        {
+            apply([this](Types&... fields) {emplace_back(std::move(fields)...);}, record);
+        };
+
+        template<typename... UTypes,
+                 typename = std::enable_if_t<sizeof...(UTypes) == sizeof...(Types)>>
+            void emplace_back(UTypes&&... args)
+            {
+                _M_emplace(std::index_sequence_for<Types...>{}, std::forward<UTypes>(args)...);
+            };
+
+        void pop_back() noexcept
+        {
+            for_each(columns, [](auto& c) {c.pop_back();});
+        };
+
+        //element access
+        reference operator[](size_t i) noexcept
+        {
+            return apply([i](auto&... c) {return reference{c[i]...};}, columns);
+        };
+
+        const_reference operator[](size_t i) const noexcept
+        {
+            return apply([i](auto const&... c) {return const_reference{c[i]...};}, columns);
+        };
+
+        iterator begin() noexcept {return iterator{this, 0};};
+        iterator end() noexcept {return iterator{this, size()};};
+        const_iterator begin() const noexcept {return const_iterator{this, 0};};
+        const_iterator end() const noexcept {return const_iterator{this, size()};};
+
+        template<size_t idx>
+            Column<_Tuple_element_t<idx, Types...>> column() noexcept
+            {
+                return {get<idx>(columns).data(), size()};
+            };
+
+        template<size_t idx>
+            Column<_Tuple_element_t<idx, Types...> const> column() const noexcept
+            {
+                return {get<idx>(columns).data(), size()};
+            };
+
+        //scans, int64 and double columns use the vector kernels
+        template<size_t idx>
+            _Tuple_element_t<idx, Types...> sum() const
+            {
+                return column_kernels::sum(_M_scan_data<idx>(), size());
+            };
+
+        template<size_t idx>
+            _Tuple_element_t<idx, Types...> min() const
+            {
+                assert(!empty());
+                return column_kernels::min(_M_scan_data<idx>(), size());
+            };
+
+        template<size_t idx>
+            _Tuple_element_t<idx, Types...> max() const
+            {
+                assert(!empty());
+                return column_kernels::max(_M_scan_data<idx>(), size());
+            };
+
+        //bitmap of the records whose field idx compares true with key
+        template<size_t idx>
+            std::vector<std::uint64_t> select(column_kernels::cmp_op op,
+                                              _Tuple_element_t<idx, Types...> const& key) const
+            {
+                std::vector<std::uint64_t> selection((size() + 63) / 64);
+                column_kernels::compare(_M_scan_data<idx>(), size(), op, key, selection.data());
+                return selection;
+            };
+
+        //field idx of the records in a selection made on any column
+        template<size_t idx>
+            std::vector<_Tuple_element_t<idx, Types...>>
+            gather(std::vector<std::uint64_t> const& selection) const
+            {
+                assert(selection.size() == (size() + 63) / 64);
+                std::vector<_Tuple_element_t<idx, Types...>> result;
+                result.reserve(column_kernels::count(selection.data(), size()));
+                column_kernels::gather(get<idx>(columns).data(), selection.data(), size(),
+                                       std::back_inserter(result));
+                return result;
+            };
+
+    private:
+        //helpers
+        //the vector kernels take exactly std::int64_t or double, other
+        //spellings of a 64-bit integer (long long on LP64) use the scalar
+        //templates rather than being read through another type
+        template<size_t idx>
+            _Tuple_element_t<idx, Types...> const* _M_scan_data() const noexcept
+            {
+                return get<idx>(columns).data();
+            };
+
+        template<size_t... I, typename... UTypes>
+            void _M_emplace(std::index_sequence<I...> seq, UTypes&&... args)
+            {
+                bool full = false;
+                for_each(columns, [&full](auto const& c) {full = full || c.size() == c.capacity();});
+
+                if(!full){
+                    _M_append(seq, std::forward<UTypes>(args)...);
+                    return;
+                }
+
+                //arguments may refer into the columns, like for std::vector,
+                //so the record is built before any column reallocates
+                value_type record(std::forward<UTypes>(args)...);
+                for_each(columns, [](auto& c) {
+                    if(c.size() == c.capacity())
+                        c.reserve(c.empty() ? 8 : 2 * c.size());
+                });
+                _M_append(seq, std::move(get<I>(record))...);
+            };
+
+        template<size_t... I, typename... UTypes>
+            void _M_append(std::index_sequence<I...>, UTypes&&... args)
+            {
+                //every column has room, so a failed element only has to
+                //undo the columns already extended
+                size_t done = 0;
+                try
+                {
+                    ((get<I>(columns).emplace_back(std::forward<UTypes>(args)), ++done), ...);
+                }
+                catch (...)
+                {
+                    ((I < done ? get<I>(columns).pop_back() : void()), ...);
+                    throw;
+                }
+            };
+
+        //member data
+        Tuple<std::vector<Types>...> columns;
+    };
+
+//counts copies and moves made by Tuple
+struct Counted
+{
+    static inline int copies = 0;
+    static inline int moves = 0;
+
+    Counted() = default;
+    Counted(Counted const&) {++copies;};
+    Counted(Counted&&) noexcept {++moves;};
+    Counted& operator=(Counted const&) {++copies; return *this;};
+    Counted& operator=(Counted&&) noexcept {++moves; return *this;};
+};
+
 int main()
 {
     //a simple test case
@@ -110,4 +1077,128 @@ int main()
 
     auto t = make_tuple(x, pi, str);
     std::cout << t;
+
+    //elements are accessed in place
+    get<0>(t) += 1;
+    get<double>(t) *= 2;
+    std::cout << get<long>(t) << ' ' << get<1>(t) << '\n';
+
+    constexpr Tuple<int, char> c{42, 'c'};
+    static_assert(get<0>(c) == 42 && get<char>(c) == 'c');
+
+    //every element is copied or moved exactly once per operation
+    Counted lvalue;
+    auto counted = make_tuple(lvalue, Counted{});
+    assert(Counted::copies == 1 && Counted::moves == 1);
+
+    auto moved = std::move(counted);
+    assert(Counted::copies == 1 && Counted::moves == 3);
+
+    moved = counted;
+    assert(Counted::copies == 3 && Counted::moves == 3);
+
+    Tuple<long, double> widened{c};
+    widened = Tuple<int, float>{1, 2.5f};
+    std::cout << get<0>(widened) << ' ' << get<1>(widened) << '\n';
+
+    //empty elements take no space, packing removes padding
+    struct Empty {};
+    static_assert(sizeof(Tuple<Empty, long>) == sizeof(long));
+    static_assert(sizeof(Packed_Tuple<char, double, char>) < sizeof(Tuple<char, double, char>));
+
+    Packed_Tuple<char, double, char> packed{'a', pi, 'b'};
+    get<1>(packed) *= 2;
+    std::cout << get<0>(packed) << ' ' << get<1>(packed) << ' ' << get<2>(packed) << '\n';
+
+    //structured bindings refer to the elements
+    auto& [number, real, text] = t;
+    number *= 2;
+    std::cout << get<0>(t) << ' ' << real << ' ' << text << '\n';
+
+    auto [first, second, third] = packed;
+    std::cout << first << second << third << '\n';
+
+    std::cout << apply([](long n, double d, char const* s) {return n + d + (s != nullptr);}, t) << '\n';
+    static_assert(apply([](int i, char ch) {return i + ch;}, c) == 42 + 'c');
+
+    for_each(t, [](auto& element) {std::cout << element << ' ';});
+    std::cout << '\n';
+
+    //printing reads elements in place, to_chars needs no stream at all
+    std::cout << separated(t, ", ") << '\n';
+
+    char buffer[64];
+    auto [end, error] = to_chars(buffer, buffer + sizeof(buffer), t, " | ");
+    assert(error == std::errc{});
+    std::cout << std::string_view(buffer, end - buffer) << '\n';
+    assert(to_chars(buffer, buffer + 4, t).ec == std::errc::value_too_large);
+
+    //records stored column by column
+    TupleVector<long, double, char const*> records;
+    for(long i = 0; i < 1000; ++i)
+        records.emplace_back(i, i * pi, str);
+    records.push_back(t);
+
+    get<0>(records[0]) = -1;
+    records[1] = records[2];
+    auto [id, value, name] = records[3];
+    value = 0.0;
+
+    double total = 0.0;
+    for(double v : records.column<1>())
+        total += v;
+
+    std::cout << records.size() << ' ' << get<0>(records[0]) << ' '
+              << get<0>(records[1]) << ' ' << id << ' ' << name << ' ' << total << '\n';
+
+    //arguments may alias elements of a full vector
+    TupleVector<std::string, long> named;
+    named.emplace_back(std::string(40, 'n'), 1L);
+    while(named.size() < 8)
+        named.emplace_back(get<0>(named[0]), get<1>(named[0]));
+    named.emplace_back(get<0>(named[0]), get<1>(named[0]));
+    assert(named.size() == 9 && get<0>(named[8]) == std::string(40, 'n'));
+
+    //column scans, a selection on one column gathers another
+    using column_kernels::cmp_op;
+    auto big = records.select<1>(cmp_op::greater_equal, 3000.0);
+    std::vector<long> big_ids = records.gather<0>(big);
+    assert(std::abs(records.sum<1>() - total) <= 1e-9 * std::abs(total));
+    assert(records.min<0>() == -1 && records.max<0>() == 999);
+    std::cout << records.sum<0>() << ' ' << big_ids.size() << ' ' << big_ids.front() << '\n';
+
+    //other spellings of a 64-bit integer take the scalar kernels
+    TupleVector<long long> counts;
+    for(long long i = 1; i <= 100; ++i)
+        counts.emplace_back(i);
+    assert(counts.sum<0>() == 5050 && counts.max<0>() == 100);
+    assert(counts.gather<0>(counts.select<0>(cmp_op::less, 3LL)).size() == 2);
+
+    //conversions between Tuples are implicit only when every element's is
+    static_assert(std::is_convertible_v<Tuple<int, char const*>, Tuple<long, std::string>>);
+    static_assert(std::is_constructible_v<Tuple<std::vector<int>>, Tuple<int>>);
+    static_assert(!std::is_convertible_v<Tuple<int>, Tuple<std::vector<int>>>);
+    static_assert(!std::is_convertible_v<Tuple<int, int> const&, Tuple<int, std::vector<int>>>);
+    Tuple<Tuple<int>> nested{Tuple<int>{7}};
+    Tuple<std::vector<int>> sized{Tuple<int>{5}};
+    assert(get<0>(get<0>(nested)) == 7 && get<0>(sized).size() == 5);
+
+    //tuples as ordered and hashed keys
+    static_assert(Tuple<int, long>{1, 2L} < Tuple<int, long>{1, 3L});
+    static_assert(Tuple<int, int>{1, 2} == Tuple<long, short>{1L, short{2}});
+    using Key = Tuple<int, int>;
+    assert(std::hash<Key>{}(Key{1, 2}) == std::hash<Key>{}(Key{1, 2}));
+    assert(Tuple<double>{1.0} != Tuple<double>{2.0});
+
+    //triviality follows the elements
+    static_assert(std::is_trivially_copyable_v<Tuple<int, double>>);
+    static_assert(std::is_trivially_destructible_v<Packed_Tuple<char, long>>);
+    static_assert(!std::is_trivially_copyable_v<Tuple<int, std::string>>);
+    static_assert(is_trivially_relocatable_v<Tuple<int&, double>>);
+
+    Tuple<int, double> from[3] = {Tuple<int, double>{1, 0.5}, Tuple<int, double>{2, 1.5},
+                                  Tuple<int, double>{3, 2.5}};
+    alignas(Tuple<int, double>) unsigned char to[sizeof(from)];
+    auto relocated = reinterpret_cast<Tuple<int, double>*>(to);
+    assert(relocate(from, from + 3, relocated) == relocated + 3 && get<0>(relocated[2]) == 3);
 }